@@ -0,0 +1,308 @@
+#include "bigint.h"
+#include "bigint_divisor.h"
+#include "gmpxx.h"
+#include "chrono"
+#include "random"
+#include "map"
+#include "memory"
+#include "sstream"
+
+/*
+ * Benchmark suite: size sweeps of every operator across its algorithm tiers, each timed against the matching GMP
+ * call on the same operands. Operands are built and converted before timing starts. Every case grows its batch
+ * until one batch takes a millisecond (which doubles as warmup), then reports the median and p99 of the per-op time
+ * over the repetitions. Output is a table, CSV or JSON; with --baseline a stored CSV run is compared case by case on
+ * the ratio to GMP, which cancels most of the difference between hosts, and any case slower than the tolerance
+ * allows makes the exit status 1.
+ *
+ * usage: bench [--ops x,s,/] [--reps N] [--quick] [--csv | --json] [--out FILE] [--baseline FILE] [--tolerance F]
+ */
+
+
+struct bench_case
+{
+    std::string op, tier;
+    u_int32_t limbs1, limbs2;
+};
+
+struct bench_result
+{
+    bench_case c;
+    double median, p99, gmp_median, gmp_p99;
+};
+
+struct bench_ops
+{
+    std::function<void()> dark, gmp;
+};
+
+static std::mt19937_64 gen(20240601);
+
+
+// Sizes are in 9-digit limbs, the tier is the one the default thresholds pick for the base 10^9 build
+static const std::vector<bench_case> cases = {
+    {"+", "linear", 1, 1}, {"+", "linear", 100, 100}, {"+", "linear", 10000, 10000}, {"+", "linear", 1000000, 1000000},
+    {"-", "linear", 1, 1}, {"-", "linear", 100, 100}, {"-", "linear", 10000, 10000}, {"-", "linear", 1000000, 1000000},
+    {"x", "schoolbook", 4, 4}, {"x", "schoolbook", 50, 50}, {"x", "karatsuba", 200, 200}, {"x", "toom3", 600, 600},
+    {"x", "toom4", 3000, 3000}, {"x", "ntt", 20000, 20000}, {"x", "ntt", 200000, 200000}, {"x", "unbalanced", 30000, 3000},
+    {"s", "schoolbook", 50, 50}, {"s", "karatsuba", 200, 200}, {"s", "toom3", 600, 600}, {"s", "toom4", 3000, 3000},
+    {"s", "ntt", 20000, 20000},
+    {"/", "small", 100, 1}, {"/", "knuth", 60, 30}, {"/", "burnikel-ziegler", 400, 200}, {"/", "burnikel-ziegler", 4000, 2000},
+    {"/", "burnikel-ziegler", 40000, 20000},
+    {"%", "knuth", 60, 30}, {"%", "burnikel-ziegler", 4000, 2000},
+    {"d", "limb", 100, 1}, {"d", "knuth", 100, 50}, {"d", "barrett", 1000, 500}, {"d", "barrett", 10000, 5000},
+    {"g", "lehmer", 10, 10}, {"g", "lehmer", 300, 300}, {"g", "half-gcd", 3000, 3000}, {"g", "half-gcd", 30000, 30000},
+    {"m", "montgomery", 32, 32}, {"m", "barrett", 32, 32}, {"m", "montgomery", 256, 256},
+    {"q", "newton", 100, 0}, {"q", "newton", 10000, 0},
+    {"o", "text", 1000, 0}, {"o", "text", 100000, 0},
+    {"i", "text", 1000, 0}, {"i", "text", 100000, 0},
+};
+
+
+std::string random_digits(u_int32_t limbs, char last = '7')
+{
+    // 9 * limbs digits with a non-zero lead, ending in `last` so moduli can be made odd or even
+    std::uniform_int_distribution<> digit(0, 9), lead(1, 9);
+    std::string ret(9 * (size_t) limbs, '0');
+    for (char &c : ret)
+        c = '0' + digit(gen);
+    ret[0] = '0' + lead(gen);
+    ret.back() = last;
+    return ret;
+}
+
+bench_ops make_ops(const bench_case &c)
+{
+    // Each pair of closures owns its operands, results land in the shared sinks so nothing is optimized away
+    std::string s1 = random_digits(c.limbs1), s2 = c.limbs2 ? random_digits(c.limbs2, c.tier == "barrett" && c.op == "m" ? '8' : '7') : "";
+    auto a = std::make_shared<bigint>(s1), b = std::make_shared<bigint>(c.limbs2 ? s2 : "1"), r = std::make_shared<bigint>();
+    auto ma = std::make_shared<mpz_class>(s1), mb = std::make_shared<mpz_class>(c.limbs2 ? s2 : "1"), mr = std::make_shared<mpz_class>();
+    const std::string &op = c.op;
+
+    if (op == "+")
+        return {[=] { *r = *a + *b; }, [=] { *mr = *ma + *mb; }};
+    if (op == "-")
+        return {[=] { *r = *a - *b; }, [=] { *mr = *ma - *mb; }};
+    if (op == "x")
+        return {[=] { *r = *a * *b; }, [=] { *mr = *ma * *mb; }};
+    if (op == "s")
+        return {[=] { *r = a->square(); }, [=] { mpz_mul(mr->get_mpz_t(), ma->get_mpz_t(), ma->get_mpz_t()); }};
+    if (op == "/")
+        return {[=] { *r = *a / *b; }, [=] { mpz_tdiv_q(mr->get_mpz_t(), ma->get_mpz_t(), mb->get_mpz_t()); }};
+    if (op == "%")
+        return {[=] { *r = *a % *b; }, [=] { mpz_tdiv_r(mr->get_mpz_t(), ma->get_mpz_t(), mb->get_mpz_t()); }};
+    if (op == "d")
+    {
+        auto divisor = std::make_shared<bigint_divisor>(*b);
+        auto q = std::make_shared<bigint>();
+        auto mq = std::make_shared<mpz_class>();
+        return {[=] { divisor->divmod(*a, *q, *r); }, [=] { mpz_tdiv_qr(mq->get_mpz_t(), mr->get_mpz_t(), ma->get_mpz_t(), mb->get_mpz_t()); }};
+    }
+    if (op == "g")
+        return {[=] { *r = bigint::gcd(*a, *b); }, [=] { mpz_gcd(mr->get_mpz_t(), ma->get_mpz_t(), mb->get_mpz_t()); }};
+    if (op == "m")
+    {
+        // base^exp mod b with a full-length exponent
+        auto e = std::make_shared<bigint>(random_digits(c.limbs1));
+        auto me = std::make_shared<mpz_class>(e->to_string());
+        return {[=] { *r = bigint::pow_mod(*a, *e, *b); }, [=] { mpz_powm(mr->get_mpz_t(), ma->get_mpz_t(), me->get_mpz_t(), mb->get_mpz_t()); }};
+    }
+    if (op == "q")
+        return {[=] { *r = bigint::isqrt(*a); }, [=] { mpz_sqrt(mr->get_mpz_t(), ma->get_mpz_t()); }};
+    if (op == "o")
+    {
+        auto text = std::make_shared<std::string>();
+        return {[=] { *text = a->to_string(); }, [=] { *text = ma->get_str(); }};
+    }
+    if (op == "i")
+    {
+        auto text = std::make_shared<std::string>(s1);
+        return {[=] { *r = bigint(*text); }, [=] { mr->set_str(*text, 10); }};
+    }
+
+    assert(false);
+    return {};
+}
+
+std::vector<double> sample(const std::function<void()> &fn, u_int32_t reps)
+{
+    // Double the batch until one takes 1ms, which keeps the clock out of tiny operations and warms caches and
+    // allocator; big operations get fewer repetitions so no case runs much beyond a second
+    auto run = [&](u_int64_t batch)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (u_int64_t k = 0; k < batch; k++)
+            fn();
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    u_int64_t batch = 1;
+    double elapsed = run(batch);
+    for (; elapsed < 1e6 && batch < (1u << 24); batch *= 2)
+        elapsed = run(2 * batch);
+    run(batch);
+
+    reps = std::max<u_int32_t>(3, std::min<double>(reps, 1e9 / elapsed));
+    std::vector<double> times(reps);
+    for (double &t : times)
+        t = run(batch) / batch;
+    std::sort(times.begin(), times.end());
+    return times;
+}
+
+double percentile(const std::vector<double> &sorted, double p)
+{
+    // Nearest rank on sorted samples
+    size_t rank = std::ceil(p * sorted.size());
+    return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+std::string key(const bench_case &c)
+{
+    return c.op + "/" + std::to_string(c.limbs1) + "/" + std::to_string(c.limbs2);
+}
+
+void write_results(std::ostream &out, const std::vector<bench_result> &results, const std::string &format, bool header = true)
+{
+    if (format == "csv")
+    {
+        if (header)
+            out << "op,tier,limbs1,limbs2,median_ns,p99_ns,gmp_median_ns,gmp_p99_ns,ratio\n";
+        for (const bench_result &r : results)
+        {
+            out << r.c.op << "," << r.c.tier << "," << r.c.limbs1 << "," << r.c.limbs2 << "," << r.median << "," << r.p99 << ","
+                << r.gmp_median << "," << r.gmp_p99 << "," << r.median / r.gmp_median << "\n";
+        }
+    }
+    else if (format == "json")
+    {
+        out << "[\n";
+        for (size_t idx = 0; idx < results.size(); idx++)
+        {
+            const bench_result &r = results[idx];
+            out << "  {\"op\": \"" << r.c.op << "\", \"tier\": \"" << r.c.tier << "\", \"limbs1\": " << r.c.limbs1 << ", \"limbs2\": "
+                << r.c.limbs2 << ", \"median_ns\": " << r.median << ", \"p99_ns\": " << r.p99 << ", \"gmp_median_ns\": " << r.gmp_median
+                << ", \"gmp_p99_ns\": " << r.gmp_p99 << ", \"ratio\": " << r.median / r.gmp_median << "}" << (idx + 1 < results.size() ? "," : "") << "\n";
+        }
+        out << "]\n";
+    }
+    else
+    {
+        if (header)
+        {
+            out << std::left << std::setw(4) << "op" << std::setw(18) << "tier" << std::right << std::setw(16) << "limbs" << std::setw(14)
+                << "median ns" << std::setw(14) << "p99 ns" << std::setw(14) << "gmp ns" << std::setw(9) << "ratio" << "\n";
+        }
+        for (const bench_result &r : results)
+        {
+            std::string limbs = std::to_string(r.c.limbs1) + (r.c.limbs2 ? " x " + std::to_string(r.c.limbs2) : "");
+            out << std::left << std::setw(4) << r.c.op << std::setw(18) << r.c.tier << std::right << std::setw(16) << limbs
+                << std::setw(14) << std::setprecision(4) << r.median << std::setw(14) << r.p99 << std::setw(14) << r.gmp_median
+                << std::setw(9) << std::setprecision(3) << r.median / r.gmp_median << "\n";
+        }
+    }
+}
+
+int check_baseline(const std::vector<bench_result> &results, const std::string &path, double tolerance)
+{
+    // The baseline is a CSV from an earlier run; cases missing on either side are skipped
+    std::ifstream in(path);
+    if (!in)
+    {
+        std::cerr << "cannot read baseline " << path << "\n";
+        return 2;
+    }
+
+    std::map<std::string, double> base;
+    std::string line;
+    std::getline(in, line);
+    while (std::getline(in, line))
+    {
+        std::vector<std::string> fields;
+        std::stringstream row(line);
+        for (std::string field; std::getline(row, field, ','); )
+            fields.emplace_back(field);
+        if (fields.size() == 9)
+            base[fields[0] + "/" + fields[2] + "/" + fields[3]] = std::stod(fields[8]);
+    }
+
+    int regressions = 0, compared = 0;
+    for (const bench_result &r : results)
+    {
+        auto it = base.find(key(r.c));
+        if (it == base.end())
+            continue;
+
+        compared++;
+        double ratio = r.median / r.gmp_median;
+        if (ratio > it->second * (1 + tolerance))
+        {
+            regressions++;
+            std::cout << "REGRESSION " << key(r.c) << " (" << r.c.tier << "): ratio " << ratio << " vs baseline " << it->second << "\n";
+        }
+    }
+
+    std::cout << compared << " cases compared, " << regressions << " regressions beyond " << 100 * tolerance << "%\n";
+    return regressions ? 1 : 0;
+}
+
+
+int main(int argc, char const *argv[])
+{
+    std::string format = "table", out_path, baseline, ops;
+    u_int32_t reps = 21;
+    double tolerance = 0.15;
+    bool quick = false;
+    for (int idx = 1; idx < argc; idx++)
+    {
+        std::string arg = argv[idx];
+        bool has_value = idx + 1 < argc;
+        if (arg == "--csv" || arg == "--json")
+            format = arg.substr(2);
+        else if (arg == "--quick")
+            quick = true;
+        else if (arg == "--ops" && has_value)
+            ops = argv[++idx];
+        else if (arg == "--reps" && has_value)
+            reps = atoi(argv[++idx]);
+        else if (arg == "--out" && has_value)
+            out_path = argv[++idx];
+        else if (arg == "--baseline" && has_value)
+            baseline = argv[++idx];
+        else if (arg == "--tolerance" && has_value)
+            tolerance = atof(argv[++idx]);
+        else
+        {
+            std::cerr << "usage: bench [--ops x,s,/] [--reps N] [--quick] [--csv | --json] [--out FILE] [--baseline FILE] [--tolerance F]\n";
+            return 2;
+        }
+    }
+
+    // The table streams row by row as cases finish, the other formats are written once at the end
+    bool stream_rows = format == "table" && out_path.empty();
+    if (stream_rows)
+        write_results(std::cout, {}, format);
+
+    std::vector<bench_result> results;
+    for (const bench_case &c : cases)
+    {
+        if ((!ops.empty() && ("," + ops + ",").find("," + c.op + ",") == std::string::npos) || (quick && c.limbs1 > 20000))
+            continue;
+
+        bench_ops fns = make_ops(c);
+        std::vector<double> dark = sample(fns.dark, reps), gmp = sample(fns.gmp, reps);
+        results.push_back({c, percentile(dark, 0.5), percentile(dark, 0.99), percentile(gmp, 0.5), percentile(gmp, 0.99)});
+        if (stream_rows)
+            write_results(std::cout, {results.back()}, format, false);
+    }
+
+    if (!out_path.empty())
+    {
+        std::ofstream out(out_path);
+        write_results(out, results, format);
+    }
+    else if (format != "table")
+        write_results(std::cout, results, format);
+
+    return baseline.empty() ? 0 : check_baseline(results, baseline, tolerance);
+}
@@ -1,4 +1,20 @@
 #include "bigint.h"
+#include "bigint_divisor.h"
+#include "task_pool.h"
+#include "limb_simd.h"
+#include "unistd.h"
+
+
+// Three NTT-friendly primes with 2^26 | p - 1, their product exceeds 2^89 which bounds every convolution coefficient
+static const u_int32_t NTT_P1 = 2'013'265'921, NTT_G1 = 31;
+static const u_int32_t NTT_P2 = 1'811'939'329, NTT_G2 = 13;
+static const u_int32_t NTT_P3 = 469'762'049, NTT_G3 = 3;
+
+__extension__ typedef unsigned __int128 u_int128_t;
+
+// Opt-in pool for the independent sub-products of multiply, forked only above parallel_threshold limbs
+static std::unique_ptr<task_pool> mul_pool;
+static u_int32_t parallel_threshold = 1000;
 
 
 /*Constructors, Destructors and Assignment*/
@@ -6,34 +22,42 @@ bigint::bigint() : neg(false), bignum(1, 0) {}
 
 bigint::bigint(int64_t num) : neg(num < 0)
 {
-    num = abs(num);
-    for (; num; num /= bigint::BASE)
-        bignum.emplace_back(num % bigint::BASE);
+    u_int64_t mag = num < 0 ? -(u_int64_t) num : num;
+    for (; mag; mag /= bigint::BASE)
+        bignum.emplace_back(mag % bigint::BASE);
 
     if (num_digits() == 0)
         bignum.emplace_back(0);
 }
 
-bigint::bigint(const std::string &num) : neg(num[0] == '-'), bignum((num.size() - (num[0] == '-' ? 2 : 1)) / 9 + 1, 0)
+bigint::bigint(const std::string &num) : neg(num[0] == '-')
 {
-    int i, j = 0;
-    for (i = num.size(); i >= (neg ? 10 : 9); i -= 9, j++)
-        bignum[j] = atoi(num.substr(i - 9, 9).c_str());
-    if ((!neg && i) || (neg && (i-1)))
-        bignum[j] = atoi(num.substr(neg, neg ? i - 1 : i).c_str());
+    const char *digits = num.data() + neg;
+    size_t len = num.size() - neg;
+    BIGINT_STAT_OP(PARSE, len / bigint::DECIMAL_DIGITS + 1);
+
+#ifdef BIGINT_BINARY_LIMBS
+    this->bignum = std::move(bigint::parse_decimal(digits, len).bignum);
+#else
+    // Limb j holds the 9 digits ending 9 * j characters from the end, the top limb may be shorter
+    bignum.resize((len + bigint::DECIMAL_DIGITS - 1) / bigint::DECIMAL_DIGITS);
+    for (size_t j = 0, end = len; j < bignum.size(); j++, end -= bigint::DECIMAL_DIGITS)
+    {
+        size_t st = end > bigint::DECIMAL_DIGITS ? end - bigint::DECIMAL_DIGITS : 0;
+        bignum[j] = bigint::parse_chunk(digits + st, end - st);
+    }
+    this->pop_leading_zeros();
+#endif
 }
 
 bigint::bigint(const bigint &num) : neg(num.neg), bignum(num.bignum) {}
 
 bigint::bigint(const bigint &num, u_int32_t st, u_int32_t end) : neg(num.neg), bignum(num.bignum.begin() + st, num.bignum.begin() + end) {}
 
-bigint::bigint(const std::vector<u_int32_t> bnum, bool sign)
+bigint::bigint(const std::vector<u_int32_t> bnum, bool sign) : neg(sign), bignum(bnum.data(), bnum.data() + bnum.size())
 {
     for (const auto &num: bignum)
         assert(num < bigint::BASE);
-
-    this->neg = sign;
-    this->bignum = bnum;
 }
 
 bigint::bigint(bigint &&num) noexcept : neg(num.neg), bignum(std::move(num.bignum)) {}
@@ -41,14 +65,20 @@ bigint::bigint(bigint &&num) noexcept : neg(num.neg), bignum(std::move(num.bignu
 bigint &bigint::operator=(const bigint &num)
 {
     if (this != &num)
+    {
+        this->neg = num.neg;
         this->bignum = num.bignum;
+    }
     return *this;
 }
 
 bigint &bigint::operator=(bigint &&num) noexcept
 {
     if (this != &num)
+    {
+        this->neg = num.neg;
         this->bignum = std::move(num.bignum);
+    }
     return *this;
 }
 
@@ -61,18 +91,406 @@ u_int64_t bigint::num_digits() const
     return bignum.size();
 }
 
-std::ostream &operator<<(std::ostream &o, const bigint &num)
+void bigint::set_threads(u_int32_t threads)
+{
+    mul_pool.reset(threads > 1 ? new task_pool(threads) : nullptr);
+}
+
+u_int32_t bigint::get_threads()
 {
-    if (num.neg)
-        o << "-";
+    return mul_pool ? mul_pool->size() : 1;
+}
+
+void bigint::set_parallel_threshold(u_int32_t limbs)
+{
+    parallel_threshold = limbs;
+}
 
-    auto it = num.bignum.rbegin();
-    o << *it;
-    for (it++; it != num.bignum.rend(); it++)
-        o << std::setfill('0') << std::setw(9) << *it;
+std::ostream &operator<<(std::ostream &o, const bigint &num)
+{
+    num.write(o);
     return o;
 }
 
+std::istream &operator>>(std::istream &i, bigint &num)
+{
+    bigint::read(i, num);
+    return i;
+}
+
+std::string bigint::to_string() const
+{
+    BIGINT_STAT_OP(FORMAT, this->num_digits());
+    std::string ret(this->neg ? "-" : "");
+#ifdef BIGINT_BINARY_LIMBS
+    bigint::text_sink out;
+    out.flush = [&](const char *text, size_t len) { ret.append(text, len); return true; };
+    bigint::write_decimal(*this, out, 0);
+    out.finish();
+#else
+    ret.resize(this->decimal_length());
+    this->write_limbs(ret.data());
+#endif
+    return ret;
+}
+
+std::to_chars_result bigint::to_chars(char *first, char *last) const
+{
+#ifdef BIGINT_BINARY_LIMBS
+    std::string digits(this->to_string());
+    if ((size_t) (last - first) < digits.size())
+        return {last, std::errc::value_too_large};
+
+    memcpy(first, digits.data(), digits.size());
+    return {first + digits.size(), std::errc()};
+#else
+    BIGINT_STAT_OP(FORMAT, this->num_digits());
+    size_t len = this->decimal_length();
+    if ((size_t) (last - first) < len)
+        return {last, std::errc::value_too_large};
+
+    this->write_limbs(first);
+    return {first + len, std::errc()};
+#endif
+}
+
+
+/*Binary serialization*/
+void bigint::save(std::ostream &out) const
+{
+    // A little-endian host writes its limbs as they are, a big-endian one swaps them a block at a time
+    bigint::file_header header{{'B', 'G', 'N', 'T'}, bigint::FILE_VERSION, bigint::file_radix(), this->neg, this->num_digits()};
+    bigint::file_order(header);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if constexpr (std::endian::native == std::endian::little)
+        out.write(reinterpret_cast<const char*>(this->bignum.data()), this->num_digits() * sizeof(u_int32_t));
+    else
+    {
+        std::vector<u_int32_t> block;
+        for (size_t st = 0; st < this->num_digits(); st += block.size())
+        {
+            block.assign(this->bignum.begin() + st, this->bignum.begin() + std::min<size_t>(st + bigint::LOAD_BLOCK, this->num_digits()));
+            bigint::file_order(block.data(), block.size());
+            out.write(reinterpret_cast<const char*>(block.data()), block.size() * sizeof(u_int32_t));
+        }
+    }
+}
+
+bigint bigint::load(std::istream &in)
+{
+    // The limbs are read straight into place, a value saved with the other radix is converted afterwards
+    bigint ret;
+    bigint::file_header header;
+    if (in.read(reinterpret_cast<char*>(&header), sizeof(header)))
+        bigint::file_order(header);
+    if (!in || !bigint::valid_header(header))
+    {
+        in.setstate(std::ios::failbit);
+        return ret;
+    }
+
+    // The limb count is untrusted. A seekable stream has to hold all of the limbs, and the buffer only grows as
+    // blocks arrive, so a corrupt count fails the read instead of allocating for it
+    std::streampos here = in.tellg();
+    if (here != std::streampos(-1))
+    {
+        in.seekg(0, std::ios::end);
+        std::streamoff left = in.tellg() - here;
+        in.seekg(here);
+        if (!in || (u_int64_t) left < header.limbs * sizeof(u_int32_t))
+        {
+            in.setstate(std::ios::failbit);
+            return ret;
+        }
+    }
+
+    for (size_t done = 0, block; done < header.limbs; done += block)
+    {
+        block = std::min<u_int64_t>(header.limbs - done, std::max(done, bigint::LOAD_BLOCK));
+        ret.bignum.resize(done + block);
+        if (!in.read(reinterpret_cast<char*>(ret.bignum.data() + done), block * sizeof(u_int32_t)))
+        {
+            in.setstate(std::ios::failbit);
+            return bigint();
+        }
+        bigint::file_order(ret.bignum.data() + done, block);
+    }
+
+    if (!bigint::valid_limbs(ret.bignum.data(), header.limbs, header.radix))
+    {
+        in.setstate(std::ios::failbit);
+        return bigint();
+    }
+
+    if (header.radix != bigint::file_radix())
+        ret = bigint::from_radix(ret.bignum.data(), header.limbs, header.radix ? INT64_C(1) << 32 : bigint::DECIMAL_BASE);
+
+    ret.neg = header.sign && !(ret.num_digits() == 1 && !ret.bignum[0]);
+    return ret;
+}
+
+u_int8_t bigint::file_radix()
+{
+#ifdef BIGINT_BINARY_LIMBS
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+bool bigint::valid_header(const file_header &header)
+{
+    return !memcmp(header.magic, "BGNT", 4) && header.version == bigint::FILE_VERSION && header.radix <= 1 && header.sign <= 1
+        && header.limbs && header.limbs <= UINT32_MAX;
+}
+
+void bigint::file_order(file_header &header)
+{
+    // Files are little-endian, swapping converts either way
+    if constexpr (std::endian::native == std::endian::big)
+    {
+        header.version = std::byteswap(header.version);
+        header.limbs = std::byteswap(header.limbs);
+    }
+}
+
+void bigint::file_order(u_int32_t *limbs, size_t n)
+{
+    if constexpr (std::endian::native == std::endian::big)
+        std::transform(limbs, limbs + n, limbs, [](u_int32_t limb) { return std::byteswap(limb); });
+}
+
+bool bigint::valid_limbs(const u_int32_t *limbs, size_t n, u_int8_t radix)
+{
+    // No leading zero limb, and base 10^9 limbs below 10^9
+    if (n > 1 && !limbs[n - 1])
+        return false;
+    return radix || std::all_of(limbs, limbs + n, [](u_int32_t limb) { return limb < 1'000'000'000; });
+}
+
+bigint bigint::from_radix(const u_int32_t *limbs, size_t n, u_int64_t radix)
+{
+    std::vector<bigint> powers(1, bigint(radix));
+    while ((u_int64_t) 1 << powers.size() < n)
+        powers.emplace_back(powers.back().square());
+    return bigint::rebase(limbs, n, powers);
+}
+
+bigint bigint::rebase(const u_int32_t *limbs, size_t n, const std::vector<bigint> &powers)
+{
+    // Limbs of the other radix, powers[j] being that radix to the 2^j: the part above the largest power of two
+    // below n times the power that spans it, plus the part below
+    if (n == 1)
+        return bigint((int64_t) limbs[0]);
+
+    u_int32_t j = std::bit_width(n - 1) - 1;
+    size_t h = (size_t) 1 << j;
+    bigint ret(bigint::rebase(limbs + h, n - h, powers) * powers[j]);
+    ret += bigint::rebase(limbs, h, powers);
+    return ret;
+}
+
+
+/*Decimal streams*/
+bool bigint::read(std::istream &in, bigint &num)
+{
+    // Characters come off the stream buffer one by one into a block, the first one after the digits stays put
+    std::istream::sentry guard(in);
+    if (!guard)
+        return false;
+
+    typedef std::istream::traits_type traits;
+    std::streambuf *buf = in.rdbuf();
+    bool negative = buf->sgetc() == '-';
+    if (negative)
+        buf->sbumpc();
+
+    bigint::digit_reader digits;
+    std::vector<char> block(bigint::TEXT_BLOCK);
+    size_t len = 0;
+    traits::int_type c = buf->sgetc();
+    for (; !traits::eq_int_type(c, traits::eof()) && isdigit(c); c = buf->snextc())
+    {
+        block[len++] = traits::to_char_type(c);
+        if (len == block.size())
+        {
+            digits.feed(block.data(), len);
+            len = 0;
+        }
+    }
+    digits.feed(block.data(), len);
+
+    if (traits::eq_int_type(c, traits::eof()))
+        in.setstate(std::ios::eofbit);
+    if (digits.empty())
+    {
+        in.setstate(std::ios::failbit);
+        return false;
+    }
+
+    num = digits.finish(negative);
+    return true;
+}
+
+bool bigint::read(int fd, bigint &num)
+{
+    // Stage 0 is leading whitespace, 1 the sign and digits, 2 trailing whitespace
+    bigint::digit_reader digits;
+    std::vector<char> block(bigint::TEXT_BLOCK);
+    auto digit = [](char c) { return c >= '0' && c <= '9'; };
+    bool negative = false;
+    int stage = 0;
+    ssize_t got;
+    while ((got = ::read(fd, block.data(), block.size())) > 0)
+    {
+        for (const char *p = block.data(), *end = p + got; p < end; )
+        {
+            if (stage == 1 && digit(*p))
+            {
+                const char *st = p;
+                while (p < end && digit(*p))
+                    p++;
+                digits.feed(st, p - st);
+            }
+            else if (isspace((unsigned char) *p))
+            {
+                stage = stage ? 2 : 0;
+                p++;
+            }
+            else if (stage == 0 && (*p == '-' || digit(*p)))
+            {
+                negative = *p == '-';
+                stage = 1;
+                p += negative;
+            }
+            else
+                return false;
+        }
+    }
+
+    if (got < 0 || digits.empty())
+        return false;
+
+    num = digits.finish(negative);
+    return true;
+}
+
+bool bigint::write(std::ostream &out) const
+{
+    bigint::text_sink sink;
+    sink.flush = [&](const char *text, size_t len) { return (bool) out.write(text, len); };
+    this->write_text(sink);
+    return sink.finish();
+}
+
+bool bigint::write(int fd) const
+{
+    bigint::text_sink sink;
+    sink.flush = [fd](const char *text, size_t len)
+    {
+        for (ssize_t put; len; text += put, len -= put)
+        {
+            if ((put = ::write(fd, text, len)) < 0)
+                return false;
+        }
+        return true;
+    };
+    this->write_text(sink);
+    return sink.finish();
+}
+
+void bigint::write_text(text_sink &out) const
+{
+    BIGINT_STAT_OP(FORMAT, this->num_digits());
+    if (this->neg)
+        *out.room(1) = '-';
+
+#ifdef BIGINT_BINARY_LIMBS
+    bigint::write_decimal(*this, out, 0);
+#else
+    char top[bigint::DECIMAL_DIGITS];
+    size_t top_len = bigint::chunk_length(this->bignum.back());
+    bigint::write_chunk(top, this->bignum.back());
+    memcpy(out.room(top_len), top + bigint::DECIMAL_DIGITS - top_len, top_len);
+    for (auto it = this->bignum.rbegin() + 1; it != this->bignum.rend(); it++)
+        bigint::write_chunk(out.room(bigint::DECIMAL_DIGITS), *it);
+#endif
+}
+
+void bigint::digit_reader::feed(const char *digits, size_t len)
+{
+    // Top up the partial group, then take whole groups straight from the text
+    size_t idx = 0;
+    for (; idx < len && (partial_len || len - idx < bigint::DECIMAL_DIGITS); idx++)
+    {
+        partial = partial * 10 + (digits[idx] - '0');
+        if (++partial_len == bigint::DECIMAL_DIGITS)
+        {
+            groups.emplace_back(partial);
+            partial = partial_len = 0;
+        }
+    }
+
+    for (; len - idx >= bigint::DECIMAL_DIGITS; idx += bigint::DECIMAL_DIGITS)
+        groups.emplace_back(bigint::parse_chunk(digits + idx, bigint::DECIMAL_DIGITS));
+    for (; idx < len; idx++, partial_len++)
+        partial = partial * 10 + (digits[idx] - '0');
+}
+
+bool bigint::digit_reader::empty() const
+{
+    return groups.empty() && !partial_len;
+}
+
+bigint bigint::digit_reader::finish(bool negative)
+{
+    // The groups are aligned to the first digit: reverse them to least significant first, then shift the whole
+    // run up by the digits of the partial group and put those in at the bottom
+    BIGINT_STAT_OP(PARSE, groups.size() + 1);
+    std::reverse(groups.begin(), groups.end());
+    u_int64_t scale = 1, carry = partial;
+    for (u_int32_t idx = 0; idx < partial_len; idx++)
+        scale *= 10;
+    for (u_int32_t &g : groups)
+    {
+        u_int64_t cur = g * scale + carry;
+        g = cur % bigint::DECIMAL_BASE;
+        carry = cur / bigint::DECIMAL_BASE;
+    }
+    if (carry || groups.empty())
+        groups.emplace_back(carry);
+
+    bigint ret;
+#ifdef BIGINT_BINARY_LIMBS
+    ret = bigint::from_radix(groups.data(), groups.size(), bigint::DECIMAL_BASE);
+#else
+    ret.bignum = std::move(groups);
+    ret.pop_leading_zeros();
+#endif
+    ret.neg = negative && !(ret.num_digits() == 1 && !ret.bignum[0]);
+    return ret;
+}
+
+char* bigint::text_sink::room(size_t len)
+{
+    if (used + len > block.size())
+    {
+        ok = ok && flush(block.data(), used);
+        used = 0;
+    }
+
+    char *at = block.data() + used;
+    used += len;
+    return at;
+}
+
+bool bigint::text_sink::finish()
+{
+    ok = ok && flush(block.data(), used);
+    used = 0;
+    return ok;
+}
+
 
 /*Arithmetic Operations*/
 bigint bigint::operator+(const bigint &num) const
@@ -91,23 +509,27 @@ bigint bigint::operator-(const bigint &num) const
 
 bigint bigint::operator*(const bigint &num) const
 {
-    bigint ret(*this);
-    ret *= num;
-    return ret;
+    return bigint::signed_multiply(*this, num);
+}
+
+bigint bigint::square() const
+{
+    // Passing the same object twice is what every multiply tier checks for to take its squaring path
+    return bigint::signed_multiply(*this, *this);
 }
 
 bigint bigint::operator/(const bigint &num) const
 {
-    bigint ret(*this);
-    ret /= num;
-    return ret;
+    bigint quotient, remainder;
+    bigint::div_rem(*this, num, quotient, remainder);
+    return quotient;
 }
 
 bigint bigint::operator%(const bigint &num) const
 {
-    bigint ret(*this);
-    ret %= num;
-    return ret;
+    bigint quotient, remainder;
+    bigint::div_rem(*this, num, quotient, remainder);
+    return remainder;
 }
 
 
@@ -213,34 +635,21 @@ bool bigint::abs_lesser_than(const bigint &num) const
 /*Arithmetic Operations updating self and private helpers*/
 bigint &bigint::operator+=(const bigint &addend)
 {
-    if (!this->neg && !addend.neg)
-        bigint::add_with_shift(*this, addend, 0);
-    else if (this->neg && !addend.neg)
-        bigint::sub(*this, addend);
-    else if (!this->neg && addend.neg)
-        bigint::sub(*this, addend);
-    else
-        bigint::add_with_shift(*this, addend, 0);
-
+    BIGINT_STAT_OP(ADD, std::max(this->num_digits(), addend.num_digits()));
+    bigint::signed_add(*this, addend, false);
     return *this;
 }
 
 bigint &bigint::operator-=(const bigint &sub)
 {
-    if (!this->neg && !sub.neg)
-        bigint::sub(*this, sub);
-    else if (this->neg && !sub.neg)
-        bigint::add_with_shift(*this, sub, 0);
-    else if (!this->neg && sub.neg)
-        bigint::add_with_shift(*this, sub, 0);
-    else
-        bigint::sub(*this, sub);
-
+    BIGINT_STAT_OP(SUB, std::max(this->num_digits(), sub.num_digits()));
+    bigint::signed_add(*this, sub, true);
     return *this;
 }
 
 bigint &bigint::operator*=(const bigint &num)
 {
+    BIGINT_STAT_OP(MUL, std::max(this->num_digits(), num.num_digits()));
     if (this->num_digits() == 1 && !this->bignum[0])
         return *this;
 
@@ -252,8 +661,9 @@ bigint &bigint::operator*=(const bigint &num)
         return *this;
     }
 
-    this->neg ^= num.neg; // Sign
+    bool sign = this->neg ^ num.neg;
     *this = std::move(bigint::multiply(*this, num, 0, this->num_digits(), 0, num.num_digits()));
+    this->neg = sign;
     return *this;
 }
 
@@ -278,312 +688,2387 @@ void bigint::add_with_shift(bigint &a, const bigint &b, u_int64_t sb)
     if (b.num_digits() > 1)
         assert(b.bignum[b.num_digits() - 1]);
 
-    for (uint32_t i = a.num_digits(); i < sb; i++)
-        a.bignum.emplace_back(0);
-
-    uint32_t carry = 0, i;
-    for (i = sb; i < b.num_digits() + sb; i++)
-    {
-        if (i == a.num_digits())
-        {
-            a.bignum.emplace_back(b.bignum[i - sb] + carry);
-            carry = a.bignum[i] / bigint::BASE;
-            a.bignum[i] %= bigint::BASE;
-        }
-
-        else
-        {
-            a.bignum[i] += b.bignum[i - sb] + carry;
-            carry = a.bignum[i] / bigint::BASE;
-            a.bignum[i] %= bigint::BASE;
-        }
-    }
+    if (b.num_digits() == 1 && !b.bignum[0])
+        return;
 
-    for (; i < a.num_digits() && carry; i++)
-    {
-        a.bignum[i] += carry;
-        carry = a.bignum[i] / bigint::BASE;
-        a.bignum[i] %= bigint::BASE;
-    }
+    size_t nb = b.num_digits();
+    if (a.num_digits() < sb + nb)
+        a.bignum.resize(sb + nb, 0);
 
+    u_int32_t *low = a.bignum.data() + sb;
+    u_int32_t carry = bigint::add_n(low, low, b.bignum.data(), nb);
+    carry = bigint::add_1(low + nb, low + nb, a.num_digits() - sb - nb, carry);
     if (carry)
         a.bignum.emplace_back(carry);
 }
 
-bigint bigint::_add_split(const bigint &a, u_int32_t st, u_int32_t end, u_int32_t split)
+void bigint::_sub(limb_vector &a, const limb_vector &b)
 {
-    bigint ret;
-    ret.bignum.clear();
-    uint64_t i, j, carry = 0;
-    for (i = st, j = split; i < split && j < end; i++, j++)
+    // Ensure there are no leading zeros
+    if (a.size() > 1)
+        assert(a[a.size() - 1]);
+    if (b.size() > 1)
+        assert(b[b.size() - 1]);
+
+    u_int32_t borrow = bigint::sub_n(a.data(), a.data(), b.data(), b.size());
+    bigint::sub_1(a.data() + b.size(), a.data() + b.size(), a.size() - b.size(), borrow);
+}
+
+bigint bigint::multiply(const bigint &mul1, const bigint &mul2, u_int32_t m1_st, u_int32_t m1_end, u_int32_t m2_st, u_int32_t m2_end)
+{
+    u_int32_t len1 = m1_end - m1_st, len2 = m2_end - m2_st;
+    u_int32_t min_len = std::min(len1, len2), max_len = std::max(len1, len2);
+
+    if (min_len >= bigint::NTT_THRESHOLD && len1 + len2 <= bigint::NTT_MAX_LENGTH)
     {
-        ret.bignum.emplace_back((a.bignum[i] + a.bignum[j] + carry) % bigint::BASE);
-        carry = (a.bignum[i] + a.bignum[j] + carry) / bigint::BASE;
+        BIGINT_STAT_PATH(MUL_NTT);
+        return bigint::ntt_multiply(mul1, mul2, m1_st, m1_end, m2_st, m2_end);
     }
 
-    for (; i < split; i++)
+    if (min_len < bigint::KARATSUBA_THRESHOLD || max_len < bigint::TOOM3_THRESHOLD)
     {
-        ret.bignum.emplace_back((a.bignum[i] + carry) % bigint::BASE);
-        carry = (a.bignum[i] + carry) / bigint::BASE;
+        if (min_len < bigint::KARATSUBA_THRESHOLD)
+            BIGINT_STAT_PATH(MUL_BASECASE);
+        else
+            BIGINT_STAT_PATH(MUL_KARATSUBA);
+
+        // Schoolbook and Karatsuba work on the limb ranges directly, every temporary of the recursion
+        // lives in the thread's scratch arena so the product itself is the only allocation
+        bigint ret;
+        ret.bignum.resize(len1 + len2);
+        u_int32_t *scratch = bigint::scratch_arena(bigint::karatsuba_scratch(max_len));
+        bigint::karatsuba_kernel(ret.bignum.data(), mul1.bignum.data() + m1_st, len1, mul2.bignum.data() + m2_st, len2, scratch);
+        ret.pop_leading_zeros();
+        return ret;
     }
 
-    for (; j < end; j++)
+    // Lopsided operands would leave the upper half of the shorter one empty
+    if (min_len <= (max_len + 1) >> 1)
     {
-        ret.bignum.emplace_back((a.bignum[j] + carry) % bigint::BASE);
-        carry = (a.bignum[j] + carry) / bigint::BASE;
+        BIGINT_STAT_PATH(MUL_UNBALANCED);
+        return bigint::unbalanced_multiply(mul1, mul2, m1_st, m1_end, m2_st, m2_end);
     }
 
-    if (carry)
-        ret.bignum.emplace_back(carry);
+    if (max_len >= bigint::TOOM4_THRESHOLD)
+    {
+        BIGINT_STAT_PATH(MUL_TOOM4);
+        return bigint::toom4_multiply(mul1, mul2, m1_st, m1_end, m2_st, m2_end);
+    }
 
-    return ret;
+    BIGINT_STAT_PATH(MUL_TOOM3);
+    return bigint::toom3_multiply(mul1, mul2, m1_st, m1_end, m2_st, m2_end);
 }
 
-void bigint::_sub(std::vector<u_int32_t> &a, const std::vector<u_int32_t> &b)
+bigint bigint::unbalanced_multiply(const bigint &mul1, const bigint &mul2, u_int32_t m1_st, u_int32_t m1_end, u_int32_t m2_st, u_int32_t m2_end)
 {
-    // Ensure there are no leading zeros
-    if (a.size() > 1)
-        assert(a[a.size() - 1]);
-    if (b.size() > 1)
-        assert(b[b.size() - 1]);
+    if (m1_end - m1_st < m2_end - m2_st)
+        return bigint::unbalanced_multiply(mul2, mul1, m2_st, m2_end, m1_st, m1_end);
 
-    size_t l, borrow, nborrow;
-    for (l = 0, borrow = 0, nborrow = 0; l < b.size(); l++, borrow = nborrow)
+    // Cut the longer operand into chunks as long as the shorter one so that every partial product is balanced
+    u_int32_t chunk = m2_end - m2_st;
+    bigint ret;
+    for (u_int32_t st = m1_st; st < m1_end; st += chunk)
     {
-        if (a[l] < borrow + b[l])
-        {
-            a[l] += BASE;
-            nborrow = 1;
-        }
-        else
-            nborrow = 0;
-        a[l] -= borrow + b[l];
+        bigint part(bigint::multiply(mul1, mul2, st, std::min(st + chunk, m1_end), m2_st, m2_end));
+        part.pop_leading_zeros();
+        bigint::add_with_shift(ret, part, st - m1_st);
     }
 
-    for (; l < a.size(); l++, borrow = nborrow)
-    {
-        if (a[l] < borrow)
-        {
-            a[l] += BASE;
-            nborrow = 1;
-        }
-        else
-            nborrow = 0;
-        a[l] -= borrow;
-    }
+    ret.pop_leading_zeros();
+    return ret;
 }
 
-void bigint::sub(bigint &a, const bigint &b)
+bigint bigint::toom3_multiply(const bigint &mul1, const bigint &mul2, u_int32_t m1_st, u_int32_t m1_end, u_int32_t m2_st, u_int32_t m2_end)
 {
-    bool orig = a.neg;
-    a.neg = b.neg;
-    if (a.operator==(b))
+    // Toom-3 evaluating at 0, 1, -1, -2 and infinity (Bodrato's interpolation sequence)
+    u_int32_t s = (std::max(m1_end - m1_st, m2_end - m2_st) + 2) / 3;
+    bool square = bigint::same_range(mul1, mul2, m1_st, m1_end, m2_st, m2_end);
+
+    // Evaluation, p[0..4] hold the values at 0, 1, -1, -2 and infinity
+    auto evaluate = [s](const bigint &num, u_int32_t st, u_int32_t end, bigint (&p)[5])
     {
-        a.bignum.clear();
-        a.bignum.emplace_back(0);
-        return;
-    }
+        bigint c0(bigint::split_piece(num, st, st + s, end));
+        bigint c1(bigint::split_piece(num, st + s, st + 2 * s, end));
+        bigint c2(bigint::split_piece(num, st + 2 * s, end, end));
+
+        p[1] = c0;
+        bigint::add_with_shift(p[1], c2, 0);
+        p[2] = p[1];
+        bigint::signed_add(p[1], c1, false);
+        bigint::signed_add(p[2], c1, true);
+        p[3] = p[2];
+        bigint::signed_add(p[3], c2, false);
+        p[3] *= 2u;
+        bigint::signed_add(p[3], c0, true);
+
+        p[0] = std::move(c0);
+        p[4] = std::move(c2);
+    };
+
+    // A square only evaluates one operand and every pointwise product stays a square
+    bigint pa[5], pb[5], r[5];
+    evaluate(mul1, m1_st, m1_end, pa);
+    if (!square)
+        evaluate(mul2, m2_st, m2_end, pb);
+    const bigint (&qb)[5] = square ? pa : pb;
+
+    std::vector<std::function<void()>> products;
+    for (u_int32_t k = 0; k < 5; k++)
+        products.emplace_back([&, k] { r[k] = bigint::signed_multiply(pa[k], qb[k]); });
+    bigint::run_parallel(3 * s, products);
+    bigint &r0 = r[0], &r1 = r[1], &r2 = r[2], &r3 = r[3], &r4 = r[4];
+
+    // Interpolation
+    bigint::signed_add(r3, r1, true);
+    bigint::div_small_exact(r3, 3);  // r3 = (r(-2) - r(1)) / 3
+    bigint::signed_add(r1, r2, true);
+    bigint::div_small_exact(r1, 2);  // r1 = (r(1) - r(-1)) / 2
+    bigint::signed_add(r2, r0, true); // r2 = r(-1) - r(0)
+    bigint::signed_add(r3, r2, true);
+    r3.neg = !r3.neg && !(r3.num_digits() == 1 && !r3.bignum[0]);
+    bigint::div_small_exact(r3, 2);
+    bigint twice_r4(r4);
+    twice_r4 *= 2u;
+    bigint::signed_add(r3, twice_r4, false); // r3 = (r2 - r3) / 2 + 2 r(inf)
+    bigint::signed_add(r2, r1, false);
+    bigint::signed_add(r2, r4, true);  // r2 = r2 + r1 - r(inf)
+    bigint::signed_add(r1, r3, true);  // r1 = r1 - r3
+
+    // Recomposition, all coefficients are non-negative by now
+    assert(!r1.neg && !r2.neg && !r3.neg);
+    bigint::add_with_shift(r0, r1, s);
+    bigint::add_with_shift(r0, r2, 2 * s);
+    bigint::add_with_shift(r0, r3, 3 * s);
+    bigint::add_with_shift(r0, r4, 4 * s);
+    return std::move(r0);
+}
+
+bigint bigint::toom4_multiply(const bigint &mul1, const bigint &mul2, u_int32_t m1_st, u_int32_t m1_end, u_int32_t m2_st, u_int32_t m2_end)
+{
+    // Toom-4 evaluating at 0, 1, -1, 2, -2, 1/2 and infinity
+    u_int32_t s = (std::max(m1_end - m1_st, m2_end - m2_st) + 3) / 4;
+    bool square = bigint::same_range(mul1, mul2, m1_st, m1_end, m2_st, m2_end);
 
-    if (a.abs_greater_than(b))
+    bigint a[4], b[4];
+    for (u_int32_t k = 0; k < 4; k++)
     {
-        a.neg = orig;
-        bigint::_sub(a.bignum, b.bignum);
-        a.pop_leading_zeros();
+        a[k] = bigint::split_piece(mul1, m1_st + k * s, k == 3 ? m1_end : m1_st + (k + 1) * s, m1_end);
+        if (!square)
+            b[k] = bigint::split_piece(mul2, m2_st + k * s, k == 3 ? m2_end : m2_st + (k + 1) * s, m2_end);
     }
 
-    else
+    // Evaluation, p[0..6] hold the values at 0, 1, -1, 2, -2, 1/2 (scaled by 8) and infinity
+    auto evaluate = [](const bigint (&c)[4], bigint (&p)[7])
+    {
+        bigint even(c[0]), odd(c[1]);
+        bigint::add_with_shift(even, c[2], 0);
+        bigint::add_with_shift(odd, c[3], 0);
+        p[1] = even;
+        bigint::add_with_shift(p[1], odd, 0);
+        p[2] = even;
+        bigint::signed_add(p[2], odd, true);
+
+        bigint even2(c[2]), odd2(c[3]);
+        even2 *= 4u;
+        bigint::add_with_shift(even2, c[0], 0);
+        odd2 *= 4u;
+        bigint::add_with_shift(odd2, c[1], 0);
+        odd2 *= 2u;
+        p[3] = even2;
+        bigint::add_with_shift(p[3], odd2, 0);
+        p[4] = even2;
+        bigint::signed_add(p[4], odd2, true);
+
+        p[5] = c[0];
+        p[5] *= 2u;
+        bigint::add_with_shift(p[5], c[1], 0);
+        p[5] *= 2u;
+        bigint::add_with_shift(p[5], c[2], 0);
+        p[5] *= 2u;
+        bigint::add_with_shift(p[5], c[3], 0);
+
+        p[0] = c[0];
+        p[6] = c[3];
+    };
+
+    bigint pa[7], pb[7], r[7];
+    evaluate(a, pa);
+    if (!square)
+        evaluate(b, pb);
+    const bigint (&qb)[7] = square ? pa : pb;
+
+    std::vector<std::function<void()>> products;
+    for (u_int32_t k = 0; k < 7; k++)
+        products.emplace_back([&, k] { r[k] = bigint::signed_multiply(pa[k], qb[k]); });
+    bigint::run_parallel(4 * s, products);
+
+    // Interpolation, solving for the coefficients with exact divisions by 2, 3, 4 and 5
+    bigint e1(r[1]), o1(std::move(r[1])), e2(r[3]), o2(std::move(r[3]));
+    bigint::signed_add(e1, r[2], false);
+    bigint::div_small_exact(e1, 2);  // r0 + r2 + r4 + r6
+    bigint::signed_add(o1, r[2], true);
+    bigint::div_small_exact(o1, 2);  // r1 + r3 + r5
+    bigint::signed_add(e2, r[4], false);
+    bigint::div_small_exact(e2, 2);  // r0 + 4 r2 + 16 r4 + 64 r6
+    bigint::signed_add(o2, r[4], true);
+    bigint::div_small_exact(o2, 4);  // r1 + 4 r3 + 16 r5
+
+    bigint sixty_four_r6(r[6]);
+    sixty_four_r6 *= 64u;
+    bigint::signed_add(e1, r[0], true);
+    bigint::signed_add(e1, r[6], true);    // r2 + r4
+    bigint::signed_add(e2, r[0], true);
+    bigint::signed_add(e2, sixty_four_r6, true);
+    bigint::div_small_exact(e2, 4);        // r2 + 4 r4
+    r[4] = e2;
+    bigint::signed_add(r[4], e1, true);
+    bigint::div_small_exact(r[4], 3);
+    r[2] = std::move(e1);
+    bigint::signed_add(r[2], r[4], true);
+
+    bigint c(std::move(r[5])), tmp(r[0]);
+    tmp *= 64u;
+    bigint::signed_add(c, tmp, true);
+    tmp = r[2];
+    tmp *= 16u;
+    bigint::signed_add(c, tmp, true);
+    tmp = r[4];
+    tmp *= 4u;
+    bigint::signed_add(c, tmp, true);
+    bigint::signed_add(c, r[6], true);
+    bigint::div_small_exact(c, 2);         // 16 r1 + 4 r3 + r5
+
+    bigint d(std::move(o2));
+    bigint::signed_add(d, o1, true);
+    bigint::div_small_exact(d, 3);         // r3 + 5 r5
+    bigint e(o1);
+    e *= 16u;
+    bigint::signed_add(e, c, true);
+    bigint::div_small_exact(e, 3);         // 4 r3 + 5 r5
+    r[3] = std::move(e);
+    bigint::signed_add(r[3], d, true);
+    bigint::div_small_exact(r[3], 3);
+    r[5] = std::move(d);
+    bigint::signed_add(r[5], r[3], true);
+    bigint::div_small_exact(r[5], 5);
+    r[1] = std::move(o1);
+    bigint::signed_add(r[1], r[3], true);
+    bigint::signed_add(r[1], r[5], true);
+
+    // Recomposition
+    bigint ret(std::move(r[0]));
+    for (u_int32_t k = 1; k < 7; k++)
     {
-        bigint a_cpy = std::move(a); // Move a into a copy
-        a = b;                       // Copy b into a
-        bigint::_sub(a.bignum, a_cpy.bignum);
-        a.pop_leading_zeros();
+        assert(!r[k].neg);
+        bigint::add_with_shift(ret, r[k], k * s);
     }
+    return ret;
 }
 
-bigint bigint::multiply(const bigint &mul1, const bigint &mul2, u_int32_t m1_st, u_int32_t m1_end, u_int32_t m2_st, u_int32_t m2_end)
+bigint bigint::ntt_multiply(const bigint &mul1, const bigint &mul2, u_int32_t m1_st, u_int32_t m1_end, u_int32_t m2_st, u_int32_t m2_end)
 {
-    if (m1_end - m1_st < 100 || m2_end - m2_st < 100 || m1_end - m1_st != m2_end - m2_st)
+    u_int32_t len = m1_end - m1_st + m2_end - m2_st, size = 1;
+    while (size < len)
+        size <<= 1;
+
+    std::vector<u_int32_t> c1, c2, c3;
+    std::vector<std::function<void()>> convolutions = {
+        [&] { c1 = bigint::ntt_convolve<NTT_P1, NTT_G1>(mul1, mul2, m1_st, m1_end, m2_st, m2_end, size); },
+        [&] { c2 = bigint::ntt_convolve<NTT_P2, NTT_G2>(mul1, mul2, m1_st, m1_end, m2_st, m2_end, size); },
+        [&] { c3 = bigint::ntt_convolve<NTT_P3, NTT_G3>(mul1, mul2, m1_st, m1_end, m2_st, m2_end, size); }};
+    bigint::run_parallel(len, convolutions);
+
+    // Garner's CRT: coefficient = x1 + x2 * P1 + x3 * P1 * P2, then carry into base BASE limbs
+    const u_int64_t inv_p1 = bigint::mod_pow_u32(NTT_P1, NTT_P2 - 2, NTT_P2);
+    const u_int64_t inv_p1p2 = bigint::mod_pow_u32((u_int64_t) NTT_P1 * NTT_P2 % NTT_P3, NTT_P3 - 2, NTT_P3);
+    const u_int128_t p1p2 = (u_int128_t) NTT_P1 * NTT_P2;
+
+    bigint ret;
+    ret.bignum.resize(len);
+    u_int128_t carry = 0;
+    for (u_int32_t k = 0; k < len; k++)
     {
-        // Regular multiplication in the "base case"
-        bigint m1(mul1, m1_st, m1_end);
-        bigint m2(mul2, m2_st, m2_end);
-        bigint::regular_multiplication(m1, m2);
-        return m1;
+        u_int64_t x1 = c1[k];
+        u_int64_t x2 = (c2[k] + NTT_P2 - x1 % NTT_P2) * inv_p1 % NTT_P2;
+        u_int64_t x12 = x1 + x2 * NTT_P1;
+        u_int64_t x3 = (c3[k] + NTT_P3 - x12 % NTT_P3) * inv_p1p2 % NTT_P3;
+
+        carry += x12 + x3 * p1p2;
+        ret.bignum[k] = carry % bigint::BASE;
+        carry /= bigint::BASE;
     }
 
-    // Karatsuba
-    u_int32_t mid = m1_end - m1_st != m2_end - m2_st ? std::min(m1_end, m2_end) - 1 : (m1_st + m1_end) >> 1;
-    // u_int32_t mid = (m1_st + m1_end) >> 1;
-    bigint lmul(bigint::multiply(mul1, mul2, m1_st, mid, m2_st, mid));
-    bigint rmul(bigint::multiply(mul1, mul2, mid, m1_end, mid, m2_end));
-
-    bigint top_sum(bigint::_add_split(mul1, m1_st, m1_end, mid));
-    bigint bottom_sum(bigint::_add_split(mul2, m2_st, m2_end, mid));
-    bigint midmul(bigint::multiply(top_sum, bottom_sum, 0, top_sum.num_digits(), 0, bottom_sum.num_digits()));
-    bigint::_sub(midmul.bignum, lmul.bignum);
-    midmul.pop_leading_zeros();
-    bigint::_sub(midmul.bignum, rmul.bignum);
-    midmul.pop_leading_zeros();
+    assert(!carry);
+    ret.pop_leading_zeros();
+    return ret;
+}
 
-    mid -= m1_st;
-    bigint::add_with_shift(lmul, midmul, mid);
-    bigint::add_with_shift(lmul, rmul, mid << 1);
-    return lmul;
+template <u_int32_t MOD, u_int32_t ROOT>
+std::vector<u_int32_t> bigint::ntt_convolve(const bigint &mul1, const bigint &mul2, u_int32_t m1_st, u_int32_t m1_end, u_int32_t m2_st, u_int32_t m2_end, u_int32_t size)
+{
+    std::vector<u_int32_t> fa(size, 0);
+    BIGINT_STAT_ALLOC(size * sizeof(u_int32_t));
+    for (u_int32_t idx = m1_st; idx < m1_end; idx++)
+        fa[idx - m1_st] = mul1.bignum[idx] % MOD;
+    bigint::ntt_transform<MOD, ROOT>(fa, false);
+
+    // A square transforms its operand once
+    if (bigint::same_range(mul1, mul2, m1_st, m1_end, m2_st, m2_end))
+    {
+        for (u_int32_t idx = 0; idx < size; idx++)
+            fa[idx] = (u_int64_t) fa[idx] * fa[idx] % MOD;
+    }
+    else
+    {
+        std::vector<u_int32_t> fb(size, 0);
+        BIGINT_STAT_ALLOC(size * sizeof(u_int32_t));
+        for (u_int32_t idx = m2_st; idx < m2_end; idx++)
+            fb[idx - m2_st] = mul2.bignum[idx] % MOD;
+        bigint::ntt_transform<MOD, ROOT>(fb, false);
+        for (u_int32_t idx = 0; idx < size; idx++)
+            fa[idx] = (u_int64_t) fa[idx] * fb[idx] % MOD;
+    }
+    bigint::ntt_transform<MOD, ROOT>(fa, true);
+    return fa;
 }
 
-void bigint::regular_multiplication(bigint &mul, const bigint &num)
+template <u_int32_t MOD, u_int32_t ROOT>
+void bigint::ntt_transform(std::vector<u_int32_t> &a, bool invert)
 {
-    int new_len = mul.num_digits() + num.num_digits() + 1;
-    bigint orig(std::move(mul));
-    mul.bignum.resize(new_len);
+    BIGINT_STAT_KERNEL(NTT_TRANSFORM);
+    u_int32_t n = a.size();
+    for (u_int32_t i = 1, j = 0; i < n; i++)
+    {
+        u_int32_t bit = n >> 1;
+        for (; j & bit; bit >>= 1)
+            j ^= bit;
+        j ^= bit;
 
-    for (u_int64_t i = 0; i < num.num_digits(); i++)
+        if (i < j)
+            std::swap(a[i], a[j]);
+    }
+
+    std::vector<u_int32_t> roots(std::max(n >> 1, 1u));
+    BIGINT_STAT_ALLOC(roots.size() * sizeof(u_int32_t));
+    for (u_int32_t len = 2; len <= n; len <<= 1)
     {
-        if (num.bignum[i])
-        {
-            u_int64_t carry = 0, j;
-            for (j = 0; j < orig.num_digits(); j++)
-            {
-                u_int64_t prod = (u_int64_t) orig.bignum[j] * num.bignum[i], new_dig = prod + carry + mul.bignum[i + j];
-                mul.bignum[i + j] = new_dig % bigint::BASE;
-                carry = new_dig / bigint::BASE;
-            }
+        u_int32_t half = len >> 1;
+        u_int64_t wlen = bigint::mod_pow_u32(ROOT, (MOD - 1) / len, MOD);
+        if (invert)
+            wlen = bigint::mod_pow_u32(wlen, MOD - 2, MOD);
+
+        roots[0] = 1;
+        for (u_int32_t j = 1; j < half; j++)
+            roots[j] = roots[j - 1] * wlen % MOD;
 
-            for (u_int64_t idx = i + j; carry; idx++)
+        for (u_int32_t i = 0; i < n; i += len)
+        {
+            for (u_int32_t j = 0; j < half; j++)
             {
-                mul.bignum[idx] += carry;
-                carry = mul.bignum[idx] / bigint::BASE;
-                mul.bignum[idx] %= bigint::BASE;
+                u_int32_t u = a[i + j], v = (u_int64_t) a[i + j + half] * roots[j] % MOD;
+                a[i + j] = u + v < MOD ? u + v : u + v - MOD;
+                a[i + j + half] = u >= v ? u - v : u + MOD - v;
             }
         }
     }
 
-    mul.pop_leading_zeros();
+    if (invert)
+    {
+        u_int64_t n_inv = bigint::mod_pow_u32(n, MOD - 2, MOD);
+        for (u_int32_t &x : a)
+            x = x * n_inv % MOD;
+    }
 }
 
-bigint &bigint::operator*=(u_int32_t num)
+void bigint::karatsuba_kernel(u_int32_t *r, const u_int32_t *a, u_int32_t na, const u_int32_t *b, u_int32_t nb, u_int32_t *scratch)
 {
-    u_int32_t carry = 0;
-
-    for (u_int32_t &dig : this->bignum)
+    // r[0 .. na + nb) = a * b, the operands may carry leading zeros and scratch holds karatsuba_scratch(max(na, nb)) limbs
+    if (na < nb)
     {
-        u_int64_t prod = dig;
-        prod *= num;
-        prod += carry;
-        dig = prod % bigint::BASE;
-        carry = prod / bigint::BASE;
+        std::swap(a, b);
+        std::swap(na, nb);
     }
 
-    if (carry)
-        this->bignum.emplace_back(carry);
+    if (nb < bigint::KARATSUBA_THRESHOLD)
+    {
+        if (a == b && na == nb)
+            bigint::sqr_basecase(r, a, na);
+        else
+            bigint::mul_basecase(r, a, na, b, nb);
+        return;
+    }
+
+    if (nb <= (na + 1) >> 1)
+    {
+        // Lopsided, multiply nb-limb chunks of a and accumulate them
+        std::fill(r, r + na + nb, 0);
+        for (u_int32_t st = 0; st < na; st += nb)
+        {
+            u_int32_t len = std::min(nb, na - st);
+            bigint::karatsuba_kernel(scratch, a + st, len, b, nb, scratch + 2 * nb);
+            bigint::add_limbs(r + st, na + nb - st, scratch, len + nb);
+        }
+        return;
+    }
+
+    // a = a1 * BASE^h + a0, b = b1 * BASE^h + b0 and a * b = a1 b1 BASE^2h + ((a0 + a1)(b0 + b1) - a0 b0 - a1 b1) BASE^h + a0 b0
+    u_int32_t h = (na + 1) >> 1;
+    u_int32_t *sa = scratch, *sb = sa + h + 1, *mid = sb + h + 1, *rest = mid + 2 * h + 2;
+    u_int32_t la = bigint::add_halves(sa, a, h, na), lb = la;
+    if (a == b && na == nb)
+        sb = sa;  // squaring, all three products below are squares again
+    else
+        lb = bigint::add_halves(sb, b, h, nb);
+
+    bigint::karatsuba_kernel(mid, sa, la, sb, lb, rest);
+    bigint::karatsuba_kernel(r, a, h, b, h, rest);
+    bigint::karatsuba_kernel(r + 2 * h, a + h, na - h, b + h, nb - h, rest);
+
+    bigint::sub_limbs(mid, la + lb, r, 2 * h);
+    bigint::sub_limbs(mid, la + lb, r + 2 * h, na + nb - 2 * h);
+    bigint::add_limbs(r + h, na + nb - h, mid, la + lb);
+}
+
+u_int32_t bigint::add_halves(u_int32_t *r, const u_int32_t *a, u_int32_t h, u_int32_t n)
+{
+    // r = a[0 .. h) + a[h .. n), returns the length of r which is h or h + 1
+    u_int32_t carry = bigint::add_n(r, a, a + h, n - h);
+    r[h] = bigint::add_1(r + n - h, a + n - h, 2 * h - n, carry);
+    return h + r[h];
+}
+
+void bigint::add_limbs(u_int32_t *a, u_int32_t na, const u_int32_t *b, u_int32_t nb)
+{
+    // a += b, the sum must fit in na limbs so any limbs of b past na are zero
+    for (; nb > na; nb--)
+        assert(!b[nb - 1]);
+
+    u_int32_t carry = bigint::add_n(a, a, b, nb);
+    carry = bigint::add_1(a + nb, a + nb, na - nb, carry);
+    assert(!carry);
+}
+
+void bigint::sub_limbs(u_int32_t *a, u_int32_t na, const u_int32_t *b, u_int32_t nb)
+{
+    // a -= b where a >= b and nb <= na
+    u_int32_t borrow = bigint::sub_n(a, a, b, nb);
+    borrow = bigint::sub_1(a + nb, a + nb, na - nb, borrow);
+    assert(!borrow);
+}
+
+u_int32_t bigint::karatsuba_scratch(u_int32_t n)
+{
+    // Each Karatsuba level keeps both half sums and the middle product, then recurses on at most h + 1 limbs
+    u_int32_t limbs = 0;
+    for (; n >= bigint::KARATSUBA_THRESHOLD; n = ((n + 1) >> 1) + 1)
+        limbs += 4 * (((n + 1) >> 1) + 1);
+    return limbs;
+}
+
+u_int32_t* bigint::scratch_arena(u_int32_t limbs)
+{
+    // Grown once per thread to the largest request, the kernels never fork so a thread uses it for one product at a time
+    static thread_local std::vector<u_int32_t> arena;
+    if (arena.size() < limbs)
+    {
+        arena.resize(std::max<size_t>(limbs, 2 * arena.size()));
+        BIGINT_STAT_ALLOC(arena.size() * sizeof(u_int32_t));
+    }
+    return arena.data();
+}
+
+void bigint::run_parallel(u_int32_t len, std::vector<std::function<void()>> &jobs)
+{
+    if (!mul_pool || len < parallel_threshold)
+    {
+        for (auto &job : jobs)
+            job();
+        return;
+    }
+
+    // Fork all but the first job, run that one on this thread and help out until the rest are done
+    std::vector<task_pool::task> tasks(jobs.size() - 1);
+    for (u_int32_t k = 1; k < jobs.size(); k++)
+    {
+        tasks[k - 1].fn = std::move(jobs[k]);
+        mul_pool->fork(tasks[k - 1]);
+    }
+
+    jobs[0]();
+    for (task_pool::task &t : tasks)
+        mul_pool->join(t);
+}
+
+u_int32_t bigint::mod_pow_u32(u_int64_t base, u_int64_t exp, u_int32_t mod)
+{
+    u_int64_t ret = 1;
+    for (base %= mod; exp; exp >>= 1, base = base * base % mod)
+    {
+        if (exp & 1)
+            ret = ret * base % mod;
+    }
+    return ret;
+}
+
+bigint bigint::split_piece(const bigint &num, u_int32_t st, u_int32_t end, u_int32_t limit)
+{
+    st = std::min(st, limit);
+    end = std::min(end, limit);
+    if (st >= end)
+        return bigint();
+
+    bigint ret(num, st, end);
+    ret.neg = false;
+    ret.pop_leading_zeros();
+    return ret;
+}
+
+bigint bigint::signed_multiply(const bigint &a, const bigint &b)
+{
+    if (&a == &b)
+        BIGINT_STAT_OP(SQR, a.num_digits());
+    else
+        BIGINT_STAT_OP(MUL, std::max(a.num_digits(), b.num_digits()));
+    bool sign = a.neg ^ b.neg;
+    bigint ret(bigint::multiply(a, b, 0, a.num_digits(), 0, b.num_digits()));
+    ret.pop_leading_zeros();
+    ret.neg = sign && !(ret.num_digits() == 1 && !ret.bignum[0]);
+    return ret;
+}
+
+bool bigint::same_range(const bigint &mul1, const bigint &mul2, u_int32_t m1_st, u_int32_t m1_end, u_int32_t m2_st, u_int32_t m2_end)
+{
+    return &mul1 == &mul2 && m1_st == m2_st && m1_end == m2_end;
+}
+
+void bigint::shift_limbs(bigint &a, int64_t limbs)
+{
+    // Multiplies by BASE^limbs, dropping limbs (truncating) when it is negative
+    if (a.num_digits() == 1 && !a.bignum[0])
+        return;
+
+    if (limbs >= 0)
+        a.bignum.insert(a.bignum.begin(), limbs, 0);
+    else if ((u_int64_t) -limbs >= a.num_digits())
+    {
+        a.bignum.assign(1, 0);
+        a.neg = false;
+    }
+    else
+        a.bignum.erase(a.bignum.begin(), a.bignum.begin() - limbs);
+}
+
+void bigint::signed_add(bigint &a, const bigint &b, bool negate)
+{
+    // a += (negate ? -b : b), respecting the signs of both operands
+    bool b_neg = b.neg ^ negate;
+    if (a.neg == b_neg)
+    {
+        bigint::add_with_shift(a, b, 0);
+        return;
+    }
+
+    if (!b.abs_greater_than(a))
+        bigint::_sub(a.bignum, b.bignum);
+    else
+    {
+        limb_vector diff(b.bignum);
+        bigint::_sub(diff, a.bignum);
+        a.bignum = std::move(diff);
+        a.neg = b_neg;
+    }
+
+    a.pop_leading_zeros();
+    if (a.num_digits() == 1 && !a.bignum[0])
+        a.neg = false;
+}
+
+void bigint::div_small_exact(bigint &a, u_int32_t d)
+{
+    [[maybe_unused]] u_int32_t rem = bigint::div_small(a, d);
+    assert(!rem);
+}
+
+bigint bigint::div_mod(const bigint &dividend, const bigint &divisor, bool div)
+{
+    bigint quotient, remainder;
+    bigint::div_rem(dividend, divisor, quotient, remainder);
+    return std::move(div ? quotient : remainder);
+}
+
+void bigint::div_rem(const bigint &dividend, const bigint &divisor, bigint &quotient, bigint &remainder)
+{
+    assert(divisor.num_digits() > 1 || divisor.bignum[0]);
+    BIGINT_STAT_OP(DIV, dividend.num_digits());
+
+    if (divisor.abs_greater_than(dividend))
+    {
+        quotient = bigint(0);
+        remainder = dividend;
+        return;
+    }
+
+    if (!divisor.abs_lesser_than(dividend))
+    {
+        quotient = bigint(dividend.neg ^ divisor.neg ? -1 : 1);
+        remainder = bigint(0);
+        return;
+    }
+
+    if (divisor.num_digits() == 1)
+    {
+        BIGINT_STAT_PATH(DIV_LIMB);
+        quotient = dividend;
+        remainder = bigint(bigint::div_small(quotient, divisor.bignum[0]));
+    }
+    else if (divisor.num_digits() < bigint::BZ_THRESHOLD || dividend.num_digits() - divisor.num_digits() < bigint::BZ_THRESHOLD)
+    {
+        BIGINT_STAT_PATH(DIV_KNUTH);
+        bigint::knuth_divide(dividend, divisor, quotient, remainder);
+    }
+    else if (divisor.num_digits() >= bigint::NEWTON_THRESHOLD)
+    {
+        BIGINT_STAT_PATH(DIV_NEWTON);
+        bigint::newton_divide(dividend, divisor, quotient, remainder);
+    }
+    else
+    {
+        BIGINT_STAT_PATH(DIV_BZ);
+        bigint::bz_divide(dividend, divisor, quotient, remainder);
+    }
+
+    quotient.neg = divisor.neg ^ dividend.neg;
+    remainder.neg = dividend.neg && !(remainder.num_digits() == 1 && !remainder.bignum[0]);
+}
+
+void bigint::knuth_divide(const bigint &dividend, const bigint &divisor, bigint &quotient, bigint &remainder)
+{
+    // Knuth's Algorithm D: scale so the top divisor limb is at least BASE / 2, then every trial
+    // quotient from the top two remainder limbs is at most two too large
+    u_int32_t n = divisor.num_digits(), m = dividend.num_digits() - n;
+    u_int32_t scale = bigint::BASE / ((u_int64_t) divisor.bignum[n - 1] + 1);
+
+    limb_vector &u = remainder.bignum;
+    u.reserve(m + n + 1);
+    u.assign(dividend.bignum.begin(), dividend.bignum.end());
+    u.emplace_back(0);
+    remainder *= scale;
+    u.resize(m + n + 1, 0);
+
+    bigint v(divisor);
+    v *= scale;
+    v.pop_leading_zeros();
+    assert(v.num_digits() == n && v.bignum[n - 1] >= bigint::BASE / 2);
+
+    quotient.bignum.assign(m + 1, 0);
+    bigint::knuth_core(u.data(), m, v.bignum.data(), n, UINT64_MAX / v.bignum[n - 1], quotient.bignum.data());
+    quotient.pop_leading_zeros();
+    u.resize(n);
+    remainder.pop_leading_zeros();
+    bigint::div_small_exact(remainder, scale);
+}
+
+void bigint::knuth_core(u_int32_t *u, u_int32_t m, const u_int32_t *v, u_int32_t n, u_int64_t v_inv, u_int32_t *q)
+{
+    BIGINT_STAT_KERNEL(KNUTH_CORE);
+    // q[0 .. m] = u[0 .. m + n] / v and u[0 .. n) = the remainder, for a normalized n-limb v (n >= 2) with
+    // v_inv = (2^64 - 1) / v[n - 1] standing in for the division of every trial quotient
+    const u_int64_t v_top = v[n - 1], v_next = v[n - 2];
+    for (int64_t j = m; j >= 0; j--)
+    {
+        u_int64_t num = (u_int64_t) u[j + n] * bigint::BASE + u[j + n - 1];
+        u_int64_t qhat = ((u_int128_t) num * v_inv) >> 64, rhat = num - qhat * v_top;
+        for (; rhat >= v_top; rhat -= v_top)
+            qhat++;
+
+        while (qhat >= bigint::BASE || qhat * v_next > rhat * bigint::BASE + u[j + n - 2])
+        {
+            qhat--;
+            rhat += v_top;
+            if (rhat >= bigint::BASE)
+                break;
+        }
+
+        // u[j .. j + n] -= qhat * v
+        int64_t top = (int64_t) u[j + n] - bigint::submul_1(u + j, v, n, qhat);
+        if (top < 0)
+        {
+            // qhat was one too large, add the divisor back
+            qhat--;
+            top += bigint::add_n(u + j, u + j, v, n);
+        }
+
+        u[j + n] = top;
+        q[j] = qhat;
+    }
+}
+
+void bigint::bz_divide(const bigint &dividend, const bigint &divisor, bigint &quotient, bigint &remainder)
+{
+    // Burnikel-Ziegler: pad the divisor to m * 2^k limbs with m <= BZ_THRESHOLD so that halving it k times
+    // lands exactly on the schoolbook case, and scale it like Knuth's algorithm
+    u_int32_t n = divisor.num_digits(), k = 0;
+    while ((n + (1u << k) - 1) >> k > bigint::BZ_THRESHOLD)
+        k++;
+    u_int32_t block = ((n + (1u << k) - 1) >> k) << k, pad = block - n;
+    u_int32_t scale = bigint::BASE / ((u_int64_t) divisor.bignum[n - 1] + 1);
+
+    bigint b(divisor), a(dividend);
+    b.neg = a.neg = false;
+    b *= scale;
+    a *= scale;
+    bigint::shift_limbs(b, pad);
+    bigint::shift_limbs(a, pad);
+
+    // Blocks of the dividend, the top one being smaller than the divisor
+    u_int32_t blocks = std::max<u_int32_t>(2, (a.num_digits() + block) / block);
+    bigint z(bigint::split_piece(a, (blocks - 2) * block, a.num_digits(), a.num_digits())), q, r;
+    quotient = bigint();
+    for (int64_t i = blocks - 2; i >= 0; i--)
+    {
+        bigint::bz_div_2n1n(z, b, block, q, r);
+        bigint::add_with_shift(quotient, q, i * block);
+        if (i > 0)
+        {
+            bigint::shift_limbs(r, block);
+            bigint::add_with_shift(r, bigint::split_piece(a, (i - 1) * block, i * block, a.num_digits()), 0);
+            z = std::move(r);
+        }
+    }
+
+    quotient.pop_leading_zeros();
+    bigint::shift_limbs(r, -(int64_t) pad);
+    bigint::div_small_exact(r, scale);
+    remainder = std::move(r);
+}
+
+void bigint::bz_div_2n1n(const bigint &a, const bigint &b, u_int32_t n, bigint &quotient, bigint &remainder)
+{
+    // a < b * BASE^n, b has n limbs and is normalized
+    if (!b.abs_greater_than(a))
+    {
+        if (n & 1 || n <= bigint::BZ_THRESHOLD)
+        {
+            bigint::knuth_divide(a, b, quotient, remainder);
+            return;
+        }
+    }
+    else
+    {
+        quotient = bigint();
+        remainder = a;
+        return;
+    }
+
+    u_int32_t h = n >> 1;
+    bigint q1, r1;
+    bigint::bz_div_3n2n(bigint::split_piece(a, h, a.num_digits(), a.num_digits()), b, h, q1, r1);
+    bigint::shift_limbs(r1, h);
+    bigint::add_with_shift(r1, bigint::split_piece(a, 0, h, a.num_digits()), 0);
+    bigint::bz_div_3n2n(r1, b, h, quotient, remainder);
+    bigint::add_with_shift(quotient, q1, h);
+}
+
+void bigint::bz_div_3n2n(const bigint &a, const bigint &b, u_int32_t h, bigint &quotient, bigint &remainder)
+{
+    // a < b * BASE^h, b has 2h limbs and is normalized
+    bigint b1(bigint::split_piece(b, h, b.num_digits(), b.num_digits()));
+    bigint b2(bigint::split_piece(b, 0, h, b.num_digits()));
+    bigint a12(bigint::split_piece(a, h, a.num_digits(), a.num_digits()));
+    bigint a1(bigint::split_piece(a, 2 * h, a.num_digits(), a.num_digits()));
+
+    bigint r1;
+    if (a1.abs_lesser_than(b1))
+        bigint::bz_div_2n1n(a12, b1, h, quotient, r1);
+    else
+    {
+        // The quotient estimate saturates at BASE^h - 1, so r1 = a12 - (BASE^h - 1) * b1
+        quotient.bignum.assign(h, bigint::BASE - 1);
+        quotient.neg = false;
+        r1 = a12 + b1;
+        bigint shifted_b1(b1);
+        bigint::shift_limbs(shifted_b1, h);
+        r1 -= shifted_b1;
+    }
+
+    bigint::shift_limbs(r1, h);
+    r1 += bigint::split_piece(a, 0, h, a.num_digits());
+    r1 -= quotient * b2;
+    while (r1.neg)
+    {
+        bigint::signed_add(quotient, bigint(1), true);
+        r1 += b;
+    }
+    remainder = std::move(r1);
+}
+
+void bigint::newton_divide(const bigint &dividend, const bigint &divisor, bigint &quotient, bigint &remainder)
+{
+    // With x ~ BASE^(2N) / (divisor * BASE^s) and N >= len(dividend) - len(divisor), the truncated
+    // product dividend * x / BASE^(2N - s) is within a few units of the quotient
+    u_int32_t n = divisor.num_digits(), len = dividend.num_digits();
+    u_int32_t big_n = std::max(n, len - n), s = big_n - n;
+
+    bigint d(divisor), a(dividend);
+    d.neg = a.neg = false;
+    bigint::shift_limbs(d, s);
+    bigint x(bigint::reciprocal(d));
+    d = divisor;
+    d.neg = false;
+
+    // Limbs of the dividend below BASE^(n - 2) move the product by less than one unit of the quotient
+    bigint a_top(a);
+    bigint::shift_limbs(a_top, -(int64_t) (n - 2));
+    quotient = a_top * x;
+    bigint::shift_limbs(quotient, -(int64_t) (2 * big_n - s - n + 2));
+    remainder = a - quotient * d;
+    while (remainder.neg)
+    {
+        bigint::signed_add(quotient, bigint(1), true);
+        remainder += d;
+    }
+    while (!remainder.abs_lesser_than(d))
+    {
+        bigint::signed_add(quotient, bigint(1), false);
+        remainder -= d;
+    }
+}
+
+bigint bigint::reciprocal(const bigint &d)
+{
+    // BASE^(2n) / d for an n-limb d, within a few units: one Newton step from the reciprocal of the top
+    // half plus two guard limbs, whose error is squared away by the step
+    u_int32_t n = d.num_digits();
+    bigint power;
+    power.bignum.assign(2 * n + 1, 0);
+    power.bignum[2 * n] = 1;
+
+    if (n < bigint::BZ_THRESHOLD)
+    {
+        bigint q, r;
+        bigint::knuth_divide(power, d, q, r);
+        return q;
+    }
+
+    u_int32_t h = (n + 1) / 2 + 2;
+    bigint x(bigint::reciprocal(bigint::split_piece(d, n - h, n, n)));
+    bigint::shift_limbs(x, n - h);
+
+    // x += x * (BASE^(2n) - d * x) / BASE^(2n)
+    bigint err(power - d * x), step(x * err);
+    bigint::shift_limbs(step, -(int64_t) (2 * n));
+    x += step;
+
+    return x;
+}
+
+limb_vector bigint::barrett_inverse(const bigint &d)
+{
+    // Barrett's mu = BASE^(2n) / |d| as n + 1 limbs. Only d = BASE^(n - 1) reaches BASE^(n + 1), it is clamped to
+    // BASE^(n + 1) - 1 which costs the quotient estimate at most one more correction
+    u_int32_t n = d.num_digits();
+    bigint power, q, r;
+    power.bignum.assign(2 * n + 1, 0);
+    power.bignum[2 * n] = 1;
+    bigint::div_rem(power, d, q, r);
+
+    if (q.num_digits() > n + 1)
+        q.bignum.assign(n + 1, bigint::BASE - 1);
+    q.bignum.resize(n + 1, 0);
+    return std::move(q.bignum);
+}
+
+u_int32_t bigint::div_small(bigint &a, u_int32_t d)
+{
+    // a /= d in place, returns the remainder
+    u_int32_t rem = bigint::div_limb(a.bignum.data(), a.bignum.data(), a.num_digits(), d, UINT64_MAX / d);
+    a.pop_leading_zeros();
+    return rem;
+}
+
+u_int32_t bigint::div_limb(u_int32_t *q, const u_int32_t *a, size_t n, u_int32_t d, u_int64_t d_inv)
+{
+    // q[0 .. n) = a / d in a single pass from the top limb, returns a mod d. q may alias a, or be null when only the
+    // remainder is wanted. Each quotient limb comes from a multiply by d_inv = (2^64 - 1) / d, which is at most two
+    // short, instead of a hardware division
+    u_int64_t rem = 0;
+    for (size_t idx = n; idx-- > 0; )
+    {
+        u_int64_t cur = rem * bigint::BASE + a[idx];
+        u_int64_t limb = ((u_int128_t) cur * d_inv) >> 64;
+        for (rem = cur - limb * d; rem >= d; rem -= d)
+            limb++;
+        if (q)
+            q[idx] = limb;
+    }
+    return rem;
+}
+
+u_int64_t bigint::mod_wide(const u_int32_t *a, size_t n, u_int64_t d)
+{
+    // a[0 .. n) mod d for d >= BASE, where a step no longer fits div_limb's 64 bits. Its reciprocal becomes
+    // Moller and Granlund's v = (2^128 - 1) / (d << s) - 2^64 with d << s normalized to its top bit: the estimate
+    // of each 128 by 64-bit step needs at most two corrections, and the division computing v is the only one
+    int s = std::countl_zero(d);
+    u_int64_t dn = d << s, v = ~(u_int128_t) 0 / dn - ((u_int128_t) 1 << 64), rem = 0;
+    for (size_t idx = n; idx-- > 0; )
+    {
+        u_int128_t num = ((u_int128_t) rem * bigint::BASE + a[idx]) << s;
+        u_int64_t hi = num >> 64, lo = num;
+        u_int128_t q = (u_int128_t) v * hi + num;
+        u_int64_t r = lo - ((u_int64_t) (q >> 64) + 1) * dn;
+        if (r > (u_int64_t) q)
+            r += dn;
+        if (r >= dn)
+            r -= dn;
+        rem = r >> s;
+    }
+    return rem;
+}
+
+
+/*Machine integer operands*/
+void bigint::add_small(bool negative, u_int64_t mag)
+{
+    // this += (-1)^negative mag. Like signs carry up from the bottom limb until the carry runs out, unlike signs
+    // borrow the same way unless mag is the larger magnitude, and then both fit in 64 bits
+    BIGINT_STAT_OP(ADD, this->num_digits());
+    if (!mag)
+        return;
+
+    u_int64_t small;
+    if (this->neg != negative && this->small_magnitude(small) && small < mag)
+    {
+        *this = bigint::from_magnitude(negative, mag - small);
+        return;
+    }
+
+    if (this->neg == negative)
+    {
+        u_int64_t carry = mag;
+        for (size_t idx = 0; carry && idx < this->bignum.size(); idx++)
+        {
+            u_int64_t sum = this->bignum[idx] + carry % bigint::BASE;
+            carry = carry / bigint::BASE + (sum >= bigint::BASE);
+            this->bignum[idx] = sum - (sum >= bigint::BASE ? bigint::BASE : 0);
+        }
+        for (; carry; carry /= bigint::BASE)
+            this->bignum.emplace_back(carry % bigint::BASE);
+        return;
+    }
+
+    u_int64_t borrow = mag;
+    for (size_t idx = 0; borrow; idx++)
+    {
+        u_int64_t sub = borrow % bigint::BASE;
+        borrow /= bigint::BASE;
+        if (this->bignum[idx] < sub)
+        {
+            this->bignum[idx] = this->bignum[idx] + bigint::BASE - sub;
+            borrow++;
+        }
+        else
+            this->bignum[idx] -= sub;
+    }
+
+    this->pop_leading_zeros();
+    if (this->num_digits() == 1 && !this->bignum[0])
+        this->neg = false;
+}
+
+void bigint::mul_small(bool negative, u_int64_t mag)
+{
+    // A multiplier below the limb base is one mul_1 pass, a wider one is two or three limbs for mul_basecase
+    BIGINT_STAT_OP(MUL, this->num_digits());
+    if (!mag || (this->num_digits() == 1 && !this->bignum[0]))
+    {
+        *this = bigint();
+        return;
+    }
+
+    size_t n = this->num_digits();
+    if (mag < bigint::BASE)
+    {
+        u_int32_t carry = bigint::mul_1(this->bignum.data(), this->bignum.data(), n, mag);
+        if (carry)
+            this->bignum.emplace_back(carry);
+    }
+    else
+    {
+        u_int32_t m[3];
+        size_t nm = 0;
+        for (; mag; mag /= bigint::BASE)
+            m[nm++] = mag % bigint::BASE;
+
+        limb_vector prod(n + nm, 0);
+        bigint::mul_basecase(prod.data(), this->bignum.data(), n, m, nm);
+        this->bignum = std::move(prod);
+        this->pop_leading_zeros();
+    }
+
+    this->neg ^= negative;
+}
+
+u_int64_t bigint::divide_small(bool negative, u_int64_t mag)
+{
+    // this /= (-1)^negative mag truncating like operator/, returns the magnitude of the remainder. A divisor below
+    // the limb base is one pass of div_small, a wider one only needs Knuth when this does not fit in 64 bits
+    assert(mag);
+    BIGINT_STAT_OP(DIV, this->num_digits());
+    bool sign = this->neg ^ negative;
+    u_int64_t rem, small;
+    if (mag < bigint::BASE)
+        rem = bigint::div_small(*this, mag);
+    else if (this->small_magnitude(small))
+    {
+        rem = small % mag;
+        *this = bigint::from_magnitude(false, small / mag);
+    }
+    else
+    {
+        bigint dividend(std::move(*this)), remainder;
+        dividend.neg = false;
+        bigint::div_rem(dividend, bigint::from_magnitude(false, mag), *this, remainder);
+        remainder.small_magnitude(rem);
+    }
+
+    this->neg = sign && !(this->num_digits() == 1 && !this->bignum[0]);
+    return rem;
+}
+
+u_int64_t bigint::mod_small(u_int64_t mag) const
+{
+    // |this| mod mag in one read-only pass from the top limb
+    assert(mag);
+    BIGINT_STAT_OP(DIV, this->num_digits());
+    if (mag < bigint::BASE)
+        return bigint::div_limb(nullptr, this->bignum.data(), this->num_digits(), mag, UINT64_MAX / mag);
+
+    return bigint::mod_wide(this->bignum.data(), this->num_digits(), mag);
+}
+
+int bigint::compare_small(bool negative, u_int64_t mag) const
+{
+    // The sign of this - (-1)^negative mag
+    bool zero = this->num_digits() == 1 && !this->bignum[0];
+    if (!mag)
+        return zero ? 0 : this->neg ? -1 : 1;
+    if (this->neg != negative)
+        return this->neg ? -1 : 1;
+
+    u_int64_t small;
+    int cmp = !this->small_magnitude(small) || small > mag ? 1 : small < mag ? -1 : 0;
+    return this->neg ? -cmp : cmp;
+}
+
+bool bigint::small_magnitude(u_int64_t &mag) const
+{
+    // |this| into mag when it fits in 64 bits, which rules out anything past the top three limbs
+    mag = 0;
+    for (size_t idx = this->num_digits(); idx-- > 0; )
+    {
+        if (__builtin_mul_overflow(mag, bigint::BASE, &mag) || __builtin_add_overflow(mag, this->bignum[idx], &mag))
+            return false;
+    }
+    return true;
+}
+
+bigint bigint::from_magnitude(bool negative, u_int64_t mag)
+{
+    bigint ret;
+    ret.bignum.clear();
+    for (; mag; mag /= bigint::BASE)
+        ret.bignum.emplace_back(mag % bigint::BASE);
+    if (ret.bignum.empty())
+        ret.bignum.emplace_back(0);
+    ret.neg = negative && (ret.num_digits() > 1 || ret.bignum[0]);
+    return ret;
+}
+
+
+/*Powers, factorials and products*/
+bigint bigint::pow(const bigint &base, u_int64_t exp)
+{
+    // Left to right: every squaring is balanced and every multiply by base only adds base's length
+    if (!exp)
+        return bigint(1);
+
+    bigint result(base);
+    for (int bit = 62 - __builtin_clzll(exp); bit >= 0; bit--)
+    {
+        result = result.square();
+        if ((exp >> bit) & 1)
+            result *= base;
+    }
+    return result;
+}
+
+bigint bigint::factorial(u_int32_t n)
+{
+    // Consecutive factors are packed into single-limb leaves, which the tree then multiplies pairwise
+    std::vector<bigint> terms;
+    u_int64_t leaf = 1;
+    for (u_int64_t i = 2; i <= n; i++)
+    {
+        if (leaf * i >= bigint::BASE)
+        {
+            terms.emplace_back(leaf);
+            leaf = 1;
+        }
+        leaf *= i;
+    }
+
+    terms.emplace_back(leaf);
+    return bigint::product_tree(terms, 0, terms.size());
+}
+
+bigint bigint::binomial(u_int32_t n, u_int32_t k)
+{
+    if (k > n)
+        return bigint(0);
+
+    k = std::min(k, n - k);
+    std::vector<bigint> terms;
+    u_int64_t leaf = 1;
+    auto pack = [&](u_int64_t factor)
+    {
+        if (leaf * factor >= bigint::BASE)
+        {
+            terms.emplace_back(leaf);
+            leaf = 1;
+        }
+        leaf *= factor;
+    };
+
+    if (n <= bigint::BINOMIAL_SIEVE_LIMIT && (u_int64_t) k * 64 >= n)
+    {
+        // Factor the result instead: p appears e times, e counting the carries when adding k and n - k in
+        // base p (Kummer), and every p^e <= n so the prime powers pack into leaves like factorial's
+        std::vector<bool> composite(n + 1);
+        for (u_int64_t p = 2; p <= n; p++)
+        {
+            if (composite[p])
+                continue;
+            for (u_int64_t m = p * p; m <= n; m += p)
+                composite[m] = true;
+
+            u_int64_t power = 1;
+            for (u_int64_t q = p; q <= n; q *= p)
+            {
+                if (n / q - k / q - (n - k) / q)
+                    power *= p;
+            }
+            pack(power);
+        }
+
+        terms.emplace_back(leaf);
+        return bigint::product_tree(terms, 0, terms.size());
+    }
+
+    // (n - k + 1) ... n as a packed product tree, divided exactly by k!
+    for (u_int64_t i = n - k + 1; i <= n; i++)
+        pack(i);
+
+    terms.emplace_back(leaf);
+    bigint quotient, remainder;
+    bigint::div_rem(bigint::product_tree(terms, 0, terms.size()), bigint::factorial(k), quotient, remainder);
+    assert(remainder.num_digits() == 1 && !remainder.bignum[0]);
+    return quotient;
+}
+
+bigint bigint::product_tree(std::vector<bigint> &terms, size_t st, size_t end)
+{
+    // Split where the running limb count crosses half, so both halves carry about the same weight
+    if (end - st <= 1)
+        return end == st ? bigint(1) : std::move(terms[st]);
+
+    u_int64_t total = 0, half = 0;
+    for (size_t idx = st; idx < end; idx++)
+        total += terms[idx].num_digits();
+
+    size_t mid = st;
+    for (; mid < end - 1 && 2 * (half + terms[mid].num_digits()) <= total; mid++)
+        half += terms[mid].num_digits();
+    mid = std::max(mid, st + 1);
+    if (!mul_pool || total < parallel_threshold)
+        return bigint::product_tree(terms, st, mid) * bigint::product_tree(terms, mid, end);
+
+    bigint left, right;
+    std::vector<std::function<void()>> jobs;
+    jobs.emplace_back([&] { left = bigint::product_tree(terms, st, mid); });
+    jobs.emplace_back([&] { right = bigint::product_tree(terms, mid, end); });
+    bigint::run_parallel(total, jobs);
+    return left * right;
+}
+
+
+/*Roots and perfect powers*/
+bigint bigint::isqrt(const bigint &a)
+{
+    return bigint::iroot(a, 2);
+}
+
+bigint bigint::iroot(const bigint &a, u_int32_t k)
+{
+    assert(k >= 1 && (!a.neg || k & 1));
+    if (k == 1 || (a.num_digits() == 1 && a.bignum[0] <= 1))
+        return a;
+
+    bigint mag(a), power;
+    mag.neg = false;
+    bigint root(bigint::root_newton(mag, k, power));
+    root.neg = a.neg;
+    return root;
+}
+
+bool bigint::is_perfect_square(const bigint &a)
+{
+    if (a.neg)
+        return false;
+
+    // BASE is a multiple of 64, so the low limb gives a mod 64, then 45045 = 63 * 65 * 11 rejects most of the rest
+    auto square_mod = [](u_int32_t r, u_int32_t m)
+    {
+        for (u_int32_t x = 0; x <= m / 2; x++)
+        {
+            if (x * x % m == r)
+                return true;
+        }
+        return false;
+    };
+
+    u_int32_t r = bigint::mod_u32(a, 45045);
+    if (!square_mod(a.bignum[0] % 64, 64) || !square_mod(r % 63, 63) || !square_mod(r % 65, 65) || !square_mod(r % 11, 11))
+        return false;
+
+    if (a.num_digits() == 1 && a.bignum[0] <= 1)
+        return true;
+
+    bigint power;
+    bigint::root_newton(a, 2, power);
+    return power == a;
+}
+
+bool bigint::is_perfect_power(const bigint &a)
+{
+    if (a.num_digits() == 1 && a.bignum[0] <= 1)
+        return true;
+
+    bigint mag(a);
+    mag.neg = false;
+    const long double ln = bigint::log_abs(mag), ln2 = logl(2);
+
+    // Only prime exponents need checking, and only odd ones for a negative value
+    const u_int32_t top = ln / ln2 + 1;
+    std::vector<bool> composite(top + 1);
+    for (u_int64_t p = 2; p * p <= top; p++)
+    {
+        for (u_int64_t m = p * p; !composite[p] && m <= top; m += p)
+            composite[m] = true;
+    }
+
+    // Residues modulo the two largest 32-bit primes screen candidates with small roots before a full power.
+    // For a prime q = jk + 1 a k-th power is 0 or has a^((q - 1) / k) = 1 mod q, other values pass with
+    // probability 1 / k, so exponents with large roots are screened by a few such q, small exponents by more.
+    // All moduli are collected first and a is reduced modulo them in one batch
+    const u_int32_t q1 = 4'294'967'291u, q2 = 4'294'967'279u;
+    std::vector<u_int32_t> exps, moduli{q1, q2}, first;
+    u_int32_t k = a.neg ? 3 : 2;
+    for (; k <= top && ln / k > 40 * ln2; k++)
+    {
+        if (composite[k])
+            continue;
+
+        exps.emplace_back(k);
+        first.emplace_back(moduli.size());
+        for (u_int32_t j = 2, rounds = k < 16 ? 6 : 2; rounds; j += 2)
+        {
+            u_int64_t q = (u_int64_t) j * k + 1;
+            if (q >> 32)
+                break;
+            if (bigint::is_prime_u32(q))
+            {
+                moduli.emplace_back(q);
+                rounds--;
+            }
+        }
+    }
+    first.emplace_back(moduli.size());
+
+    std::vector<u_int32_t> residues(moduli.size());
+    bigint::mod_u32_batch(mag, moduli.data(), moduli.size(), residues.data());
+    const u_int32_t r1 = residues[0], r2 = residues[1];
+
+    for (; k <= top; k++)
+    {
+        if (composite[k])
+            continue;
+
+        // The root is below 2^40, so the long double estimate is within one of it. A k-th power matches the log
+        // to far better than 10^-6, which rejects the neighbours without modular powers
+        u_int64_t r = llroundl(expl(ln / k));
+        for (u_int64_t c = std::max<u_int64_t>(r, 3) - 1; c <= r + 1; c++)
+        {
+            if (fabsl(k * logl(c) - ln) < 1e-6L && bigint::mod_pow_u32(c, k, q1) == r1 && bigint::mod_pow_u32(c, k, q2) == r2 &&
+                bigint::pow(bigint(c), k) == mag)
+                return true;
+        }
+    }
+
+    for (size_t e = 0; e < exps.size(); e++)
+    {
+        bool candidate = true;
+        for (u_int32_t idx = first[e]; candidate && idx < first[e + 1]; idx++)
+            candidate = !residues[idx] || bigint::mod_pow_u32(residues[idx], (moduli[idx] - 1) / exps[e], moduli[idx]) == 1;
+
+        bigint power;
+        if (candidate && (bigint::root_newton(mag, exps[e], power), power == mag))
+            return true;
+    }
+
+    return false;
+}
+
+bigint bigint::root_newton(const bigint &a, u_int32_t k, bigint &power)
+{
+    // floor(a^(1/k)) for a >= 2 and k >= 2, with its k-th power left in power
+    u_int32_t n = a.num_digits();
+    long double ln = bigint::log_abs(a);
+    if (ln < (k - 1) * logl(2))
+    {
+        power = bigint(1);
+        return bigint(1);
+    }
+
+    bigint x;
+    u_int32_t m = (n + k - 1) / k;
+    if (m <= 2)
+    {
+        // The root is below BASE^2: a long double estimate from the top limbs, nudged safely above it. Roots
+        // next to BASE^2 can be nudged past it, BASE^2 - 1 is still above them and keeps both limbs in range
+        long double r = std::min(expl(ln / k) * (1 + 1e-15L) + 2, (long double) bigint::BASE * bigint::BASE - 1);
+        u_int64_t hi = r / bigint::BASE;
+        x.bignum.assign(2, 0);
+        x.bignum[0] = r - (long double) hi * bigint::BASE;
+        x.bignum[1] = hi;
+        x.pop_leading_zeros();
+    }
+    else
+    {
+        // Root of the top limbs plus one, scaled by BASE^h, is above the root with a relative error about BASE^-h.
+        // With h under half the root's length one Newton step squares that away
+        u_int32_t h = (m - 1) / 2;
+        bigint top(a, k * h, n), top_power;
+        x = bigint::root_newton(top, k, top_power) + bigint(1);
+        bigint::shift_limbs(x, h);
+    }
+
+    // Newton steps x = ((k - 1) x + a / x^(k - 1)) / k never drop below the floor of the root, so the first
+    // x with x^k <= a is the answer. The start is above the root, which skips checking it
+    for (;;)
+    {
+        x = (x * bigint(k - 1) + a / (k == 2 ? x : bigint::pow(x, k - 1))) / bigint(k);
+        power = k == 2 ? x.square() : bigint::pow(x, k);
+        if (power <= a)
+            return x;
+    }
+}
+
+long double bigint::log_abs(const bigint &a)
+{
+    // Natural log of |a| from its top three limbs, good to about 2^-60 relative
+    u_int32_t n = a.num_digits(), used = std::min(n, 3u);
+    long double top = 0;
+    for (u_int32_t idx = n; idx > n - used; idx--)
+        top = top * bigint::BASE + a.bignum[idx - 1];
+    return logl(top) + (n - used) * logl(bigint::BASE);
+}
+
+u_int32_t bigint::mod_u32(const bigint &a, u_int32_t d)
+{
+    // |a| mod d without touching a
+    u_int64_t rem = 0;
+    for (u_int32_t idx = a.num_digits(); idx > 0; idx--)
+        rem = (rem * bigint::BASE + a.bignum[idx - 1]) % d;
+    return rem;
+}
+
+void bigint::mod_u32_batch(const bigint &a, const u_int32_t *d, size_t count, u_int32_t *r)
+{
+    // |a| mod each d[idx] through a remainder tree. Node k covers a range of moduli with children 2k and 2k + 1;
+    // its product is built once bottom up, then a is reduced modulo each product on the way down, so the limb
+    // passes at the leaves only see values about as long as their 16 moduli
+    const size_t LEAF = 16;
+    std::vector<bigint> tree(4 * (count / LEAF + 1));
+    auto build = [&](auto &self, size_t node, size_t st, size_t end) -> void
+    {
+        if (end - st <= LEAF)
+        {
+            tree[node] = bigint(1);
+            for (size_t idx = st; idx < end; idx++)
+                tree[node] *= d[idx];
+            return;
+        }
+        size_t mid = st + (end - st) / 2;
+        self(self, 2 * node, st, mid);
+        self(self, 2 * node + 1, mid, end);
+        tree[node] = tree[2 * node] * tree[2 * node + 1];
+    };
+    auto descend = [&](auto &self, size_t node, const bigint &rem, size_t st, size_t end) -> void
+    {
+        if (end - st <= LEAF)
+        {
+            for (size_t idx = st; idx < end; idx++)
+                r[idx] = bigint::mod_u32(rem, d[idx]);
+            return;
+        }
+        size_t mid = st + (end - st) / 2;
+        self(self, 2 * node, rem < tree[2 * node] ? rem : rem % tree[2 * node], st, mid);
+        self(self, 2 * node + 1, rem < tree[2 * node + 1] ? rem : rem % tree[2 * node + 1], mid, end);
+    };
+
+    bigint mag(a);
+    mag.neg = false;
+    build(build, 1, 0, count);
+    descend(descend, 1, mag, 0, count);
+}
+
+bool bigint::is_prime_u32(u_int32_t q)
+{
+    // Miller-Rabin to the bases 2, 7 and 61, which is exact below 2^32
+    if (q < 2 || q % 2 == 0)
+        return q == 2;
+
+    u_int32_t d = q - 1, s = 0;
+    for (; d % 2 == 0; d /= 2)
+        s++;
+
+    for (u_int64_t base : {2, 7, 61})
+    {
+        if (base % q == 0)
+            continue;
+
+        u_int64_t x = bigint::mod_pow_u32(base, d, q);
+        if (x == 1 || x == q - 1)
+            continue;
+
+        // q - 1 has to show up among the squarings
+        u_int32_t r = 1;
+        for (; r < s && x != q - 1; r++)
+            x = x * x % q;
+        if (x != q - 1)
+            return false;
+    }
+    return true;
+}
+
+
+/*Greatest common divisors*/
+bigint bigint::gcd(const bigint &a, const bigint &b)
+{
+    bigint x(a), y(b);
+    x.neg = y.neg = false;
+    if (x < y)
+        std::swap(x, y);
+
+    bigint::gcd_reduce(x, y, nullptr, nullptr);
+    return x;
+}
+
+bigint bigint::xgcd(const bigint &a, const bigint &b, bigint &s, bigint &t)
+{
+    // Only the cofactor of |a| is carried through the reduction, the other one is (g - s |a|) / |b| exactly
+    bigint x(a), y(b), sx(1), sy(0);
+    x.neg = y.neg = false;
+    if (x < y)
+    {
+        std::swap(x, y);
+        std::swap(sx, sy);
+    }
+
+    bigint::gcd_reduce(x, y, &sx, &sy);
+    bigint g(std::move(x)), mag_a(a), mag_b(b);
+    mag_a.neg = mag_b.neg = false;
+
+    if (g.num_digits() == 1 && !g.bignum[0])
+    {
+        s = t = bigint(0);
+        return g;
+    }
+
+    if (mag_b.num_digits() == 1 && !mag_b.bignum[0])
+    {
+        s = bigint(a.neg ? -1 : 1);
+        t = bigint(0);
+        return g;
+    }
+
+    // Any s + k |b| / g works, the one with |s| <= |b| / 2g keeps both cofactors small
+    bigint period(mag_b / g);
+    sx %= period;
+    bigint twice(sx + sx);
+    twice.neg = false;
+    if (twice > period)
+        bigint::signed_add(sx, period, !sx.neg);
+
+    t = (g - sx * mag_a) / mag_b;
+    s = std::move(sx);
+    if (a.neg && (s.num_digits() > 1 || s.bignum[0]))
+        s.neg = !s.neg;
+    if (b.neg && (t.num_digits() > 1 || t.bignum[0]))
+        t.neg = !t.neg;
+    return g;
+}
+
+bigint bigint::mod_inverse(const bigint &a, const bigint &m)
+{
+    assert(!m.neg && (m.num_digits() > 1 || m.bignum[0]));
+
+    bigint s, t;
+    if (bigint::xgcd(a % m, m, s, t) != bigint(1))
+        return bigint(0);
+
+    s %= m;
+    if (s.neg)
+        s += m;
+    return s;
+}
+
+void bigint::gcd_reduce(bigint &a, bigint &b, bigint *sa, bigint *sb)
+{
+    // Reduces a >= b >= 0 to (gcd, 0). Every step maps (a, b) through a matrix of determinant +-1, and maps
+    // (sa, sb) through it too when they are given
+    BIGINT_STAT_OP(GCD, a.num_digits());
+    bigint q, r;
+    int64_t l[4];
+    while (b.num_digits() > 1 || b.bignum[0])
+    {
+        if (!sa && a.num_digits() <= 2)
+        {
+            // Both fit in 64 bits from here on
+            u_int64_t x = a.bignum[0] + (a.num_digits() > 1 ? a.bignum[1] * bigint::BASE : 0);
+            u_int64_t y = b.bignum[0] + (b.num_digits() > 1 ? b.bignum[1] * bigint::BASE : 0);
+            while (y)
+                x = std::exchange(y, x % y);
+
+            a.bignum.clear();
+            for (; x; x /= bigint::BASE)
+                a.bignum.emplace_back(x % bigint::BASE);
+            b = bigint(0);
+            return;
+        }
+
+        if (b.num_digits() >= bigint::HGCD_THRESHOLD && b.num_digits() > a.num_digits() / 2 + 1)
+        {
+            BIGINT_STAT_PATH(GCD_HGCD);
+            bigint m[4];
+            bigint::hgcd(a, b, m);
+            if (sa)
+                bigint::apply_matrix(*sa, *sb, m[0], m[1], m[2], m[3]);
+        }
+        else if (bigint::lehmer_step(a, b, l))
+        {
+            BIGINT_STAT_PATH(GCD_LEHMER);
+            if (sa)
+                bigint::apply_matrix(*sa, *sb, bigint(l[0]), bigint(l[1]), bigint(l[2]), bigint(l[3]));
+        }
+        else
+        {
+            BIGINT_STAT_PATH(GCD_DIVIDE);
+            bigint::div_rem(a, b, q, r);
+            a = std::move(b);
+            b = std::move(r);
+            if (sa)
+            {
+                r = *sa - q * *sb;
+                *sa = std::move(*sb);
+                *sb = std::move(r);
+            }
+        }
+    }
+}
+
+void bigint::hgcd(bigint &a, bigint &b, bigint (&m)[4])
+{
+    // Half-gcd: (a, b) <- m (a, b) until b has at most n / 2 + 1 limbs, for a >= b >= 0 of n limbs and a matrix m
+    // of determinant +-1. Above HGCD_THRESHOLD the matrices come from the top limbs, reduced recursively: the
+    // top n - n / 2 limbs take the values to about 3n / 4 and the top half of those to about n / 2. A matrix
+    // built from approximations can overshoot the true remainder sequence, which only costs a sign or an order
+    // to fix since the gcd stays the same under any such matrix
+    u_int32_t n = a.num_digits(), s = n / 2 + 1;
+    m[0] = m[3] = bigint(1);
+    m[1] = m[2] = bigint(0);
+
+    if (n >= bigint::HGCD_THRESHOLD && b.num_digits() > s)
+    {
+        bigint::hgcd_lift(a, b, n / 2, m);
 
-    return *this;
+        u_int32_t n2 = a.num_digits();
+        if (b.num_digits() > s && 2 * s > n2 + 2)
+        {
+            bigint m2[4];
+            bigint::hgcd_lift(a, b, 2 * s - n2 - 2, m2);
+            bigint::apply_matrix(m[0], m[2], m2[0], m2[1], m2[2], m2[3]);
+            bigint::apply_matrix(m[1], m[3], m2[0], m2[1], m2[2], m2[3]);
+        }
+    }
+
+    // Lehmer and division steps close the remaining gap, and do all the work below the threshold
+    bigint q, r;
+    int64_t l[4];
+    while (b.num_digits() > s)
+    {
+        if (bigint::lehmer_step(a, b, l))
+        {
+            bigint l0(l[0]), l1(l[1]), l2(l[2]), l3(l[3]);
+            bigint::apply_matrix(m[0], m[2], l0, l1, l2, l3);
+            bigint::apply_matrix(m[1], m[3], l0, l1, l2, l3);
+            continue;
+        }
+
+        bigint::div_rem(a, b, q, r);
+        a = std::move(b);
+        b = std::move(r);
+        for (u_int32_t c = 0; c < 2; c++)
+        {
+            r = m[c] - q * m[2 + c];
+            m[c] = std::move(m[2 + c]);
+            m[2 + c] = std::move(r);
+        }
+    }
 }
 
-bigint bigint::div_mod(const bigint &dividend, const bigint &divisor, bool div)
+void bigint::hgcd_lift(bigint &a, bigint &b, u_int32_t p, bigint (&m)[4])
 {
-    if (divisor.abs_greater_than(dividend))
-        return div ? bigint(0) : dividend;
+    // Reduces (a, b) by the half-gcd matrix of their limbs from p up, for b longer than p limbs. The recursion
+    // leaves the top parts already reduced, so only the low p limbs need multiplying by m
+    bigint a_hi(a, p, a.num_digits()), b_hi(b, p, b.num_digits());
+    bigint a_lo(bigint::split_piece(a, 0, p, p)), b_lo(bigint::split_piece(b, 0, p, p));
+
+    bigint::hgcd(a_hi, b_hi, m);
+    bigint::shift_limbs(a_hi, p);
+    bigint::shift_limbs(b_hi, p);
+    a = a_hi + m[0] * a_lo + m[1] * b_lo;
+    b = b_hi + m[2] * a_lo + m[3] * b_lo;
+    bigint::gcd_normalize(a, b, m);
+}
+
+void bigint::gcd_normalize(bigint &a, bigint &b, bigint (&m)[4])
+{
+    // Restores a >= b >= 0 after an overshooting matrix, negating and swapping the rows of m to match
+    auto negate = [](bigint &x, bigint &m0, bigint &m1)
+    {
+        x.neg = false;
+        for (bigint *v : {&m0, &m1})
+        {
+            if (v->num_digits() > 1 || v->bignum[0])
+                v->neg = !v->neg;
+        }
+    };
+
+    if (a.neg)
+        negate(a, m[0], m[1]);
+    if (b.neg)
+        negate(b, m[2], m[3]);
+    if (a < b)
+    {
+        std::swap(a, b);
+        std::swap(m[0], m[2]);
+        std::swap(m[1], m[3]);
+    }
+}
+
+void bigint::apply_matrix(bigint &x, bigint &y, const bigint &m00, const bigint &m01, const bigint &m10, const bigint &m11)
+{
+    // (x, y) <- (m00 x + m01 y, m10 x + m11 y)
+    bigint next_x(m00 * x + m01 * y);
+    y = m10 * x + m11 * y;
+    x = std::move(next_x);
+}
+
+bool bigint::lehmer_step(bigint &a, bigint &b, int64_t (&m)[4])
+{
+    // Knuth's Algorithm L on the top two limbs of a >= b >= 0: a quotient of the approximations is a quotient
+    // of the full values while the two ends of its possible range agree. The cofactors stay below BASE, so
+    // (a, b) <- m (a, b) is four single-limb multiplies. Returns false when not even one quotient was found
+    u_int32_t n = a.num_digits();
+    if (n < 2 || b.num_digits() + 1 < n)
+        return false;
+
+    auto top = [n](const bigint &x)
+    {
+        u_int64_t hi = x.num_digits() >= n ? x.bignum[n - 1] : 0;
+        return hi * bigint::BASE + x.bignum[n - 2];
+    };
+
+    // Below 2^62 the sums and products of the loop fit in 64 bits
+    u_int64_t top_a = top(a), top_b = top(b);
+    u_int32_t shift = top_a >> 62 ? 2 : 0;
+    int64_t u = top_a >> shift, v = top_b >> shift;
+    int64_t A = 1, B = 0, C = 0, D = 1;
+    const u_int64_t base = bigint::BASE;
+    while (v + C > 0 && v + D > 0)
+    {
+        int64_t q = (u + A) / (v + C);
+        if (q != (u + B) / (v + D) || (u_int64_t) q >= base)
+            break;
+
+        // Signs alternate, so each new cofactor's magnitude is the old one plus q times the other
+        if ((u_int64_t) q * std::abs(C) + std::abs(A) >= base || (u_int64_t) q * std::abs(D) + std::abs(B) >= base)
+            break;
+
+        A = std::exchange(C, A - q * C);
+        B = std::exchange(D, B - q * D);
+        u = std::exchange(v, u - q * v);
+    }
+
+    if (!B)
+        return false;
+
+    // One of each pair of cofactors is at most zero, so each combination is a difference of two multiplies
+    b.bignum.resize(n, 0);
+    u_int32_t *r = bigint::scratch_arena(2 * n + 2);
+    auto combine = [&](u_int32_t *out, int64_t p, int64_t q)
+    {
+        if (q <= 0)
+            bigint::lehmer_combine(out, a.bignum.data(), p, b.bignum.data(), -q, n);
+        else
+            bigint::lehmer_combine(out, b.bignum.data(), q, a.bignum.data(), -p, n);
+    };
+    combine(r, A, B);
+    combine(r + n + 1, C, D);
+
+    a.bignum.assign(r, r + n + 1);
+    b.bignum.assign(r + n + 1, r + 2 * n + 2);
+    a.pop_leading_zeros();
+    b.pop_leading_zeros();
+
+    m[0] = A;
+    m[1] = B;
+    m[2] = C;
+    m[3] = D;
+    return true;
+}
+
+void bigint::lehmer_combine(u_int32_t *r, const u_int32_t *x, u_int32_t px, const u_int32_t *y, u_int32_t py, u_int32_t n)
+{
+    // r[0 .. n] = px x - py y for n-limb spans, when the caller knows it is not negative
+    r[n] = bigint::mul_1(r, x, n, px);
+    r[n] -= bigint::submul_1(r, y, n, py);
+}
 
-    if (!divisor.abs_lesser_than(dividend))
-        return div ? bigint(dividend.neg ^ divisor.neg ? -1 : 1) : bigint(0);
 
-    // Implement long division
-    int32_t curr_idx = dividend.num_digits() - divisor.num_digits(), div_digits = curr_idx + 1;
+/*Batch operations*/
+void bigint::batch_add(std::span<const bigint> a, std::span<const bigint> b, std::span<bigint> out)
+{
+    assert(a.size() == b.size() && a.size() == out.size());
+
+    // Copying into out reuses its limbs, so a batch run into the same outputs again does not allocate
+    bigint::batch_run(a.size(), bigint::batch_limbs(a) + bigint::batch_limbs(b), [&](size_t st, size_t end)
+    {
+        for (size_t idx = st; idx < end; idx++)
+        {
+            if (&out[idx] == &b[idx])
+                out[idx] += a[idx];
+            else
+            {
+                out[idx] = a[idx];
+                out[idx] += b[idx];
+            }
+        }
+    });
+}
 
-    bigint remainder(dividend, static_cast<u_int32_t>(curr_idx), dividend.num_digits());
-    remainder.bignum.reserve(divisor.num_digits() + 2);
-    remainder.neg = false;
-    
-    bigint div_cpy(divisor);
-    div_cpy.neg = false;
-    
-    bigint quotient;
-    quotient.bignum.reserve(div_digits+1);
+void bigint::batch_mul(std::span<const bigint> a, std::span<const bigint> b, std::span<bigint> out)
+{
+    assert(a.size() == b.size() && a.size() == out.size());
 
-    for (--curr_idx; curr_idx >= 0; curr_idx--)
+    bigint::batch_run(a.size(), bigint::batch_limbs(a) + bigint::batch_limbs(b), [&](size_t st, size_t end)
     {
-        if (remainder.abs_lesser_than(divisor))
+        for (size_t idx = st; idx < end; idx++)
         {
-            quotient.bignum.emplace_back(0);
-            auto& rem = remainder.bignum;
-            rem.emplace_back(0);
-            for (u_int32_t idx = rem.size() - 1; idx > 0; idx--)
-                rem[idx] = rem[idx - 1];
+            const bigint &x = a[idx], &y = b[idx];
+            u_int32_t nx = x.num_digits(), ny = y.num_digits();
+            if (&out[idx] == &x || &out[idx] == &y || (std::min(nx, ny) >= bigint::KARATSUBA_THRESHOLD && std::max(nx, ny) >= bigint::TOOM3_THRESHOLD))
+            {
+                out[idx] = x * y;
+                continue;
+            }
+
+            // The tier multiply would pick anyway, run straight into the output's limbs
+            limb_vector &r = out[idx].bignum;
+            r.resize(nx + ny);
+            bigint::karatsuba_kernel(r.data(), x.bignum.data(), nx, y.bignum.data(), ny, bigint::scratch_arena(bigint::karatsuba_scratch(std::max(nx, ny))));
+            out[idx].pop_leading_zeros();
+            out[idx].neg = (x.neg ^ y.neg) && !(out[idx].num_digits() == 1 && !r[0]);
         }
+    });
+}
 
-        else
-            quotient.bignum.emplace_back(bigint::div(remainder, div_cpy, divisor, true));
+void bigint::batch_mod(std::span<const bigint> a, std::span<const bigint> m, std::span<bigint> out)
+{
+    assert(a.size() == m.size() && a.size() == out.size());
+
+    bigint::batch_run(a.size(), bigint::batch_limbs(a), [&](size_t st, size_t end)
+    {
+        bigint quotient;
+        for (size_t idx = st; idx < end; idx++)
+        {
+            if (&out[idx] == &a[idx] || &out[idx] == &m[idx])
+                out[idx] = a[idx] % m[idx];
+            else
+                bigint::div_rem(a[idx], m[idx], quotient, out[idx]);
+        }
+    });
+}
+
+void bigint::batch_mod(std::span<const bigint> a, const bigint &m, std::span<bigint> out)
+{
+    assert(a.size() == out.size());
+
+    // Every chunk prepares its own divisor, whose working limbs cannot be shared between threads
+    bigint::batch_run(a.size(), bigint::batch_limbs(a), [&](size_t st, size_t end)
+    {
+        bigint_divisor divisor(m);
+        bigint quotient;
+        for (size_t idx = st; idx < end; idx++)
+            divisor.divmod(a[idx], quotient, out[idx]);
+    });
+}
+
+bigint bigint::sum(std::span<const bigint> terms)
+{
+    // Each chunk adds its own run of terms, then the partial sums are added in order
+    size_t chunks = bigint::batch_chunks(terms.size());
+    std::vector<bigint> partial(chunks);
+    bigint::batch_run(chunks, bigint::batch_limbs(terms), [&](size_t st, size_t end)
+    {
+        for (size_t c = st; c < end; c++)
+        {
+            for (size_t idx = c * terms.size() / chunks; idx < (c + 1) * terms.size() / chunks; idx++)
+                partial[c] += terms[idx];
+        }
+    });
+
+    bigint ret;
+    for (const bigint &p : partial)
+        ret += p;
+    return ret;
+}
+
+bigint bigint::product(std::span<const bigint> terms)
+{
+    return bigint::product(terms.begin(), terms.end());
+}
 
-        remainder.bignum[0] = dividend.bignum[curr_idx];
+void bigint::batch_run(size_t count, u_int64_t limbs, const std::function<void(size_t, size_t)> &chunk)
+{
+    // Splits [0, count) into batch_chunks runs that the pool's threads claim one at a time, so a run of
+    // unusually large operands holds up one thread rather than a fixed share of the batch
+    size_t chunks = bigint::batch_chunks(count);
+    if (!mul_pool || chunks <= 1 || limbs < parallel_threshold)
+    {
+        chunk(0, count);
+        return;
     }
 
-    if (!remainder.abs_lesser_than(divisor))
-        quotient.bignum.emplace_back(bigint::div(remainder, div_cpy, divisor, false));
+    std::atomic<size_t> next(0);
+    std::vector<std::function<void()>> jobs(std::min<size_t>(mul_pool->size(), chunks), [&]
+    {
+        for (size_t c; (c = next++) < chunks; )
+            chunk(c * count / chunks, (c + 1) * count / chunks);
+    });
+    bigint::run_parallel(std::min<u_int64_t>(limbs, UINT32_MAX), jobs);
+}
 
-    quotient.reverse_num();
-    quotient.pop_leading_zeros();
-    quotient.neg = divisor.neg ^ dividend.neg;
-    remainder.neg = dividend.neg;
-    return div ? quotient : remainder;
+size_t bigint::batch_chunks(size_t count)
+{
+    return std::min<size_t>(count, mul_pool ? 8 * mul_pool->size() : 1);
+}
+
+u_int64_t bigint::batch_limbs(std::span<const bigint> terms)
+{
+    u_int64_t limbs = 0;
+    for (const bigint &t : terms)
+        limbs += t.num_digits();
+    return limbs;
 }
 
-u_int32_t bigint::div(bigint &dividend, bigint &div_cpy, const bigint &divisor, bool shift)
+
+/*Modular exponentiation*/
+bigint bigint::pow_mod(const bigint &base, const bigint &exp, const bigint &mod)
 {
-    u_int32_t l = 1, r = bigint::BASE - 1;
+    assert(!mod.neg && (mod.num_digits() > 1 || mod.bignum[0]) && !exp.neg);
+    BIGINT_STAT_OP(POW_MOD, mod.num_digits());
+    if (mod.num_digits() == 1 && mod.bignum[0] == 1)
+        return bigint();
+
+    // Montgomery needs the modulus to be a unit mod BASE, i.e. odd (and not a multiple of 5 for decimal limbs)
+    mod_context ctx;
+    bigint::mod_setup(ctx, mod, std::gcd((u_int64_t) mod.bignum[0], bigint::BASE) == 1);
+    std::vector<u_int8_t> bits(bigint::exponent_bits(exp, false));
+    u_int32_t n = ctx.n, len = bits.size();
+    u_int32_t w = len > 671 ? 6 : len > 239 ? 5 : len > 79 ? 4 : len > 23 ? 3 : 1;
+
+    // Sliding window over the odd powers base, base^3, ..., base^(2^w - 1)
+    limb_vector table(n << (w - 1), 0), acc(n, 0), sq(n, 0);
+    bigint::mod_reduce_base(ctx, base, table.data());
+    if (w > 1)
+    {
+        bigint::mod_mul(ctx, sq.data(), table.data(), table.data());
+        for (u_int32_t k = 1; k < 1u << (w - 1); k++)
+            bigint::mod_mul(ctx, table.data() + k * n, table.data() + (k - 1) * n, sq.data());
+    }
 
-    while (l <= r)
+    bool started = false;
+    for (int64_t i = (int64_t) len - 1; i >= 0;)
     {
-        u_int32_t m = (l + r) >> 1;
-        bigint::mul_dig_in_place(div_cpy, divisor, m);
-        if (div_cpy.abs_greater_than(dividend))
-            r = m - 1;
+        if (!bits[i])
+        {
+            bigint::mod_mul(ctx, acc.data(), acc.data(), acc.data());
+            i--;
+            continue;
+        }
+
+        // The longest window of at most w bits that ends in a set bit
+        int64_t l = std::max<int64_t>(i - w + 1, 0);
+        while (!bits[l])
+            l++;
+        u_int32_t value = 0;
+        for (int64_t j = i; j >= l; j--)
+            value = value << 1 | bits[j];
+
+        const u_int32_t *entry = table.data() + (value >> 1) * n;
+        if (!started)
+            std::copy(entry, entry + n, acc.data());
         else
-            l = m + 1;
+        {
+            for (int64_t j = l; j <= i; j++)
+                bigint::mod_mul(ctx, acc.data(), acc.data(), acc.data());
+            bigint::mod_mul(ctx, acc.data(), acc.data(), entry);
+        }
+        started = true;
+        i = l - 1;
     }
 
-    bigint::mul_dig_in_place(div_cpy, divisor, r);
-    if (!shift)
-        dividend -= div_cpy;
-    
-    else
+    if (!started)
+        return bigint(1);
+    return bigint::mod_result(ctx, acc.data());
+}
+
+bigint bigint::pow_mod_ct(const bigint &base, const bigint &exp, const bigint &mod)
+{
+    assert(!mod.neg && (mod.num_digits() > 1 || mod.bignum[0]) && !exp.neg);
+    assert(std::gcd((u_int64_t) mod.bignum[0], bigint::BASE) == 1);
+    BIGINT_STAT_OP(POW_MOD, mod.num_digits());
+    if (mod.num_digits() == 1 && mod.bignum[0] == 1)
+        return bigint();
+
+    // Fixed CT_WINDOW-bit windows over the exponent padded to its limb count: every window squares
+    // CT_WINDOW times and multiplies by an entry read with a masked scan of the whole table
+    mod_context ctx;
+    bigint::mod_setup(ctx, mod, true);
+    std::vector<u_int8_t> bits(bigint::exponent_bits(exp, true));
+    bits.resize((bits.size() + bigint::CT_WINDOW - 1) / bigint::CT_WINDOW * bigint::CT_WINDOW, 0);
+    u_int32_t n = ctx.n, entries = 1u << bigint::CT_WINDOW;
+
+    limb_vector table(n * entries, 0), acc(n, 0), sel(n, 0);
+    bigint::mod_reduce_base(ctx, base, table.data() + n);
+    bigint::mont_mul(ctx, table.data(), ctx.one.data(), ctx.r2.data());
+    for (u_int32_t k = 2; k < entries; k++)
+        bigint::mont_mul(ctx, table.data() + k * n, table.data() + (k - 1) * n, table.data() + n);
+    std::copy(table.data(), table.data() + n, acc.data());
+
+    for (int64_t i = (int64_t) bits.size() - bigint::CT_WINDOW; i >= 0; i -= bigint::CT_WINDOW)
+    {
+        u_int32_t value = 0;
+        for (u_int32_t j = bigint::CT_WINDOW; j-- > 0;)
+            value = value << 1 | bits[i + j];
+
+        std::fill(sel.begin(), sel.end(), 0);
+        for (u_int32_t k = 0; k < entries; k++)
+        {
+            u_int32_t mask = -(u_int32_t) (k == value);
+            for (u_int32_t j = 0; j < n; j++)
+                sel[j] |= table[k * n + j] & mask;
+        }
+
+        for (u_int32_t j = 0; j < bigint::CT_WINDOW; j++)
+            bigint::mont_mul(ctx, acc.data(), acc.data(), acc.data());
+        bigint::mont_mul(ctx, acc.data(), acc.data(), sel.data());
+    }
+
+    bigint::mont_mul(ctx, acc.data(), acc.data(), ctx.one.data());
+    bigint ret;
+    ret.bignum.assign(acc.begin(), acc.end());
+    ret.pop_leading_zeros();
+    return ret;
+}
+
+void bigint::mod_setup(mod_context &ctx, const bigint &mod, bool montgomery)
+{
+    u_int32_t n = mod.num_digits();
+    ctx.n = n;
+    ctx.montgomery = montgomery;
+    ctx.mod = mod.bignum;
+    ctx.one.assign(n, 0);
+    ctx.one[0] = 1;
+    ctx.t.assign(2 * n + 2, 0);
+    ctx.q.assign(2 * n + 2, 0);
+    ctx.p.assign(2 * n + 2, 0);
+
+    if (!montgomery)
     {
-        dividend.bignum.emplace_back(0); // No reallocation needed because sufficient space was reserved
-        auto &divi = dividend.bignum;
-        auto &div = div_cpy.bignum;
+        ctx.mu = bigint::barrett_inverse(mod);
+        return;
+    }
+
+    bigint power, q, r;
+    power.bignum.assign(2 * n + 1, 0);
+    power.bignum[2 * n] = 1;
+    bigint::div_rem(power, mod, q, r);
+    ctx.inv = bigint::BASE - bigint::inverse_mod_base(mod.bignum[0]);
+    ctx.r2 = std::move(r.bignum);
+    ctx.r2.resize(n, 0);
+}
+
+void bigint::mod_mul(mod_context &ctx, u_int32_t *r, const u_int32_t *a, const u_int32_t *b)
+{
+    // r = a * b / BASE^n (Montgomery) or a * b (Barrett) mod the modulus, r may alias a or b
+    if (ctx.montgomery)
+    {
+        bigint::mont_mul(ctx, r, a, b);
+        return;
+    }
+
+    // Barrett: q = (t / BASE^(n - 1)) * mu / BASE^(n + 1) undershoots t / mod by at most two,
+    // and t - q * mod only needs its low n + 1 limbs
+    u_int32_t n = ctx.n, *t = ctx.t.data(), *q = ctx.q.data(), *p = ctx.p.data();
+    u_int32_t *scratch = bigint::scratch_arena(bigint::karatsuba_scratch(n + 1));
+    const u_int32_t *m = ctx.mod.data();
+    bigint::karatsuba_kernel(t, a, n, b, n, scratch);
+    bigint::karatsuba_kernel(q, t + n - 1, n + 1, ctx.mu.data(), n + 1, scratch);
+    bigint::karatsuba_kernel(p, q + n + 1, n + 1, m, n, scratch);
+    bigint::sub_n(t, t, p, n + 1);
+
+    while (t[n] || bigint::compare_limbs(t, m, n) >= 0)
+        t[n] -= bigint::sub_n(t, t, m, n);
+    std::copy(t, t + n, r);
+}
 
-        for (u_int32_t idx = dividend.num_digits() - 1; idx > 0; idx--)
+void bigint::mont_mul(mod_context &ctx, u_int32_t *r, const u_int32_t *a, const u_int32_t *b)
+{
+    // r = a * b / BASE^n mod the modulus, r may alias a or b. Product scanning (FIPS): column k of a * b
+    // and of u * mod is summed in a 128-bit accumulator, where u[k] is picked to clear column k for k < n.
+    // The sequence of limb operations is fixed and the final subtraction is masked, so the timing does
+    // not depend on the operands
+    u_int32_t n = ctx.n, *u = ctx.q.data(), *t = ctx.t.data(), *d = ctx.p.data();
+    const u_int32_t *m = ctx.mod.data();
+
+    // Column sums stay below 2n BASE^2. For decimal limbs BASE = 2^9 * 5^9, so shifting first leaves a division
+    // by 5^9: one 64-bit division while the sums stay below 2^73 (n up to about 4700), a long division in 32-bit
+    // steps beyond that. The choice only depends on n. No hardware divide runs, its latency depends on the
+    // operands on common cores: a quotient by 5^9 is a multiply by (2^64 - 1) / 5^9, at most two short, and
+    // two masked corrections
+    bool wide = (u_int128_t) 2 * n * bigint::BASE * bigint::BASE >= (u_int128_t) 1 << 73;
+    auto div_odd = [](u_int64_t y) -> u_int64_t
+    {
+        const u_int64_t odd = bigint::BASE >> 9, inv = UINT64_MAX / odd;
+        u_int64_t q = ((u_int128_t) y * inv) >> 64, rem = y - q * odd;
+        for (int fix = 0; fix < 2; fix++)
+        {
+            u_int64_t over = rem >= odd;
+            q += over;
+            rem -= over * odd;
+        }
+        return q;
+    };
+    auto shift = [wide, div_odd](u_int128_t x) -> u_int128_t
+    {
+        if constexpr (bigint::BASE == 1ull << 32)
+            return x >> 32;
+        else
         {
-            divi[idx] = divi[idx - 1];
+            x >>= 9;
+            if (!wide)
+                return div_odd(x);
 
-            if (idx <= div_cpy.num_digits())
+            u_int128_t q = 0;
+            u_int64_t rem = 0;
+            for (int bit = 96; bit >= 0; bit -= 32)
             {
-                if (divi[idx] < div[idx - 1]) // Cannot happen at the Most Significant Digit coz dividend >= div_cpy (by bin search)
-                {
-                    divi[idx + 1]--;
-                    divi[idx] += bigint::BASE;
-                }
-                divi[idx] -= div[idx - 1];
+                u_int64_t cur = rem << 32 | (u_int32_t) (x >> bit), part = div_odd(cur);
+                q = q << 32 | part;
+                rem = cur - part * (bigint::BASE >> 9);
             }
+            return q;
+        }
+    };
+    auto low = [&](u_int128_t x) -> u_int32_t { return (u_int64_t) x - (u_int64_t) shift(x) * bigint::BASE; };
+
+    // Column k of a * b over a[lo..hi], lo + hi = k. A square sums each symmetric pair once and doubles it
+    bool square = a == b;
+    auto column = [&](u_int32_t lo, u_int32_t hi, u_int32_t k) -> u_int128_t
+    {
+        u_int128_t sum = 0;
+        if (!square)
+        {
+            for (u_int32_t j = lo; j <= hi; j++)
+                sum += (u_int64_t) a[j] * b[k - j];
+            return sum;
         }
 
-        divi[0] = 0;
-        dividend.pop_leading_zeros();
+        for (u_int32_t j = lo; j < k - j; j++)
+            sum += (u_int64_t) a[j] * a[k - j];
+        sum += sum;
+        if (k % 2 == 0)
+            sum += (u_int64_t) a[k / 2] * a[k / 2];
+        return sum;
+    };
+
+    u_int128_t acc = 0;
+    for (u_int32_t k = 0; k < n; k++)
+    {
+        acc += column(0, k, k);
+        for (u_int32_t j = 0; j < k; j++)
+            acc += (u_int64_t) u[j] * m[k - j];
+        u[k] = low((u_int64_t) low(acc) * ctx.inv);
+        acc += (u_int64_t) u[k] * m[0];
+        acc = shift(acc);
+    }
+
+    for (u_int32_t k = n; k < 2 * n; k++)
+    {
+        acc += column(k - n + 1, n - 1, k);
+        for (u_int32_t j = k - n + 1; j < n; j++)
+            acc += (u_int64_t) u[j] * m[k - j];
+        u_int128_t carry = shift(acc);
+        t[k - n] = (u_int64_t) acc - (u_int64_t) carry * bigint::BASE;
+        acc = carry;
+    }
+
+    // t < 2 mod, keep t or t - mod depending on the borrow
+    int64_t top = (int64_t) acc - bigint::sub_n(d, t, m, n);
+    u_int32_t keep = -(u_int32_t) (top < 0);
+    for (u_int32_t j = 0; j < n; j++)
+        r[j] = (t[j] & keep) | (d[j] & ~keep);
+}
+
+void bigint::mod_reduce_base(mod_context &ctx, const bigint &base, u_int32_t *r)
+{
+    // base mod the modulus as n limbs, moved into the Montgomery domain when that is in use
+    bigint q, rem;
+    bigint mod;
+    mod.bignum = ctx.mod;
+    bigint::div_rem(base, mod, q, rem);
+    if (rem.neg)
+        rem += mod;
+
+    std::fill(r, r + ctx.n, 0);
+    std::copy(rem.bignum.begin(), rem.bignum.end(), r);
+    if (ctx.montgomery)
+        bigint::mod_mul(ctx, r, r, ctx.r2.data());
+}
+
+bigint bigint::mod_result(mod_context &ctx, const u_int32_t *x)
+{
+    bigint ret;
+    ret.bignum.assign(x, x + ctx.n);
+    if (ctx.montgomery)
+        bigint::mod_mul(ctx, ret.bignum.data(), x, ctx.one.data());
+    ret.pop_leading_zeros();
+    return ret;
+}
+
+std::vector<u_int8_t> bigint::exponent_bits(const bigint &exp, bool padded)
+{
+    // Binary digits from the least significant, padded to a size that only depends on the limb count
+    std::vector<u_int8_t> bits;
+#ifdef BIGINT_BINARY_LIMBS
+    for (u_int32_t limb : exp.bignum)
+        for (u_int32_t j = 0; j < 32; j++)
+            bits.emplace_back(limb >> j & 1);
+#else
+    // BASE^k < 2^(30 k), so 30 bits per limb always suffice
+    bigint e(exp);
+    for (u_int32_t k = 0; k < exp.num_digits(); k++)
+    {
+        u_int32_t chunk = bigint::div_small(e, 1u << 30);
+        for (u_int32_t j = 0; j < 30; j++)
+            bits.emplace_back(chunk >> j & 1);
+    }
+#endif
+
+    if (!padded)
+    {
+        while (!bits.empty() && !bits.back())
+            bits.pop_back();
+    }
+    return bits;
+}
+
+u_int32_t bigint::inverse_mod_base(u_int32_t a)
+{
+    // Newton's iteration x = x (2 - a x) doubles the number of correct low digits, starting from an
+    // inverse mod 8 (binary limbs) or mod 10 (decimal limbs)
+    static const u_int32_t inverse_mod_10[10] = {0, 1, 0, 7, 0, 0, 0, 3, 0, 9};
+    u_int128_t x = bigint::BASE == 1ull << 32 ? a : inverse_mod_10[a % 10];
+    for (u_int32_t k = 0; k < 5; k++)
+        x = x * (2 * bigint::BASE + 2 - (u_int128_t) a * x % bigint::BASE) % bigint::BASE;
+
+    assert((u_int64_t) a * x % bigint::BASE == 1);
+    return x;
+}
+
+int bigint::compare_limbs(const u_int32_t *a, const u_int32_t *b, size_t n)
+{
+    for (size_t i = n; i-- > 0;)
+    {
+        if (a[i] != b[i])
+            return a[i] < b[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+
+/*Limb span kernels*/
+u_int32_t bigint::add_n(u_int32_t *r, const u_int32_t *a, const u_int32_t *b, size_t n)
+{
+    BIGINT_STAT_KERNEL(ADD_N);
+    u_int32_t carry = 0;
+    for (size_t i = limb_simd::add_n(r, a, b, n, carry); i < n; i++)
+    {
+        u_int64_t sum = (u_int64_t) a[i] + b[i] + carry;
+        carry = sum >= bigint::BASE;
+        r[i] = sum - (carry ? bigint::BASE : 0);
+    }
+    return carry;
+}
+
+u_int32_t bigint::sub_n(u_int32_t *r, const u_int32_t *a, const u_int32_t *b, size_t n)
+{
+    BIGINT_STAT_KERNEL(SUB_N);
+    u_int32_t borrow = 0;
+    for (size_t i = limb_simd::sub_n(r, a, b, n, borrow); i < n; i++)
+    {
+        u_int64_t sub = (u_int64_t) b[i] + borrow;
+        borrow = a[i] < sub;
+        r[i] = a[i] + (borrow ? bigint::BASE : 0) - sub;
+    }
+    return borrow;
+}
+
+u_int32_t bigint::add_1(u_int32_t *r, const u_int32_t *a, size_t n, u_int32_t b)
+{
+    u_int32_t carry = b;
+    size_t i = 0;
+    for (; i < n && carry; i++)
+    {
+        u_int64_t sum = (u_int64_t) a[i] + carry;
+        carry = sum >= bigint::BASE;
+        r[i] = sum - (carry ? bigint::BASE : 0);
+    }
+
+    if (r != a)
+        std::copy(a + i, a + n, r + i);
+    return carry;
+}
+
+u_int32_t bigint::sub_1(u_int32_t *r, const u_int32_t *a, size_t n, u_int32_t b)
+{
+    u_int32_t borrow = b;
+    size_t i = 0;
+    for (; i < n && borrow; i++)
+    {
+        u_int32_t sub = borrow;
+        borrow = a[i] < sub;
+        r[i] = a[i] + (borrow ? bigint::BASE : 0) - sub;
+    }
+
+    if (r != a)
+        std::copy(a + i, a + n, r + i);
+    return borrow;
+}
+
+u_int32_t bigint::mul_1(u_int32_t *r, const u_int32_t *a, size_t n, u_int32_t b)
+{
+    BIGINT_STAT_KERNEL(MUL_1);
+    u_int32_t simd_carry = 0;
+    size_t i = limb_simd::mul_1(r, a, n, b, simd_carry);
+    u_int64_t carry = simd_carry;
+    for (; i < n; i++)
+    {
+        u_int64_t prod = (u_int64_t) a[i] * b + carry;
+        r[i] = prod % bigint::BASE;
+        carry = prod / bigint::BASE;
+    }
+    return carry;
+}
+
+u_int32_t bigint::addmul_1(u_int32_t *r, const u_int32_t *a, size_t n, u_int32_t b)
+{
+    BIGINT_STAT_KERNEL(ADDMUL_1);
+    // (BASE - 1)^2 + 2 (BASE - 1) still fits in 64 bits
+    u_int64_t carry = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        u_int64_t cur = (u_int64_t) a[i] * b + r[i] + carry;
+        r[i] = cur % bigint::BASE;
+        carry = cur / bigint::BASE;
     }
+    return carry;
+}
 
-    return r;
+u_int32_t bigint::submul_1(u_int32_t *r, const u_int32_t *a, size_t n, u_int32_t b)
+{
+    BIGINT_STAT_KERNEL(SUBMUL_1);
+    // The product carry and the subtraction borrow run as separate chains and meet at the top
+    u_int64_t carry = 0;
+    int64_t borrow = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        u_int64_t prod = (u_int64_t) a[i] * b + carry;
+        carry = prod / bigint::BASE;
+        int64_t diff = (int64_t) r[i] - (int64_t) (prod % bigint::BASE) - borrow;
+        // A sign mask rather than a select, the borrow is a coin flip that would mispredict a branch
+        int64_t mask = diff >> 63;
+        borrow = mask & 1;
+        r[i] = diff + (mask & bigint::BASE);
+    }
+    return carry + borrow;
 }
 
-void bigint::mul_dig_in_place(bigint &prod, const bigint &orig, u_int32_t digit)
+void bigint::mul_basecase(u_int32_t *r, const u_int32_t *a, size_t na, const u_int32_t *b, size_t nb)
 {
-    for (u_int32_t idx = 0; idx < orig.num_digits(); idx++)
-        prod.bignum[idx] = orig.bignum[idx];
+    BIGINT_STAT_KERNEL(BASECASE_MUL);
+    r[na] = bigint::mul_1(r, a, na, b[0]);
+    for (size_t i = 1; i < nb; i++)
+        r[na + i] = b[i] ? bigint::addmul_1(r + i, a, na, b[i]) : 0;
+}
 
-    for (u_int32_t idx = orig.num_digits(); idx < prod.num_digits(); idx++)
-        prod.bignum[idx] = 0;
-    
-    prod *= digit;
-    prod.pop_leading_zeros();
+void bigint::sqr_basecase(u_int32_t *r, const u_int32_t *a, size_t n)
+{
+    BIGINT_STAT_KERNEL(BASECASE_SQR);
+    // Every cross product a[i] a[j] with i < j once, doubled, plus the squares on the diagonal
+    r[0] = 0;
+    r[2 * n - 1] = 0;
+    std::fill(r + 1, r + n, 0);
+    for (size_t i = 0; i + 1 < n; i++)
+        r[n + i] = a[i] ? bigint::addmul_1(r + 2 * i + 1, a + i + 1, n - i - 1, a[i]) : 0;
+    [[maybe_unused]] u_int32_t top = bigint::add_n(r, r, r, 2 * n);
+    assert(!top);
+
+    u_int64_t carry = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        u_int64_t sq = (u_int64_t) a[i] * a[i];
+        u_int64_t low = r[2 * i] + sq % bigint::BASE + carry;
+        r[2 * i] = low % bigint::BASE;
+        u_int64_t high = r[2 * i + 1] + sq / bigint::BASE + low / bigint::BASE;
+        r[2 * i + 1] = high % bigint::BASE;
+        carry = high / bigint::BASE;
+    }
+    assert(!carry);
 }
 
 
@@ -594,7 +3079,138 @@ void bigint::pop_leading_zeros()
         bignum.pop_back();
 }
 
-void bigint::reverse_num()
+u_int32_t bigint::parse_chunk(const char *digits, size_t len)
+{
+    u_int32_t ret = 0;
+    for (size_t idx = 0; idx < len; idx++)
+        ret = ret * 10 + (digits[idx] - '0');
+    return ret;
+}
+
+void bigint::write_chunk(char *out, u_int32_t chunk)
+{
+    // Exactly DECIMAL_DIGITS digits, two at a time from a table of digit pairs
+    static const char pairs[] = "00010203040506070809101112131415161718192021222324252627282930313233343536373839404142434445464748495051525354555657585960616263646566676869707172737475767778798081828384858687888990919293949596979899";
+    out[0] = '0' + chunk / 100'000'000;
+    chunk %= 100'000'000;
+    for (int idx = 7; idx > 0; idx -= 2, chunk /= 100)
+        memcpy(out + idx, pairs + 2 * (chunk % 100), 2);
+}
+
+size_t bigint::chunk_length(u_int32_t chunk)
+{
+    size_t len = 1;
+    for (; chunk >= 10; chunk /= 10)
+        len++;
+    return len;
+}
+
+#ifdef BIGINT_BINARY_LIMBS
+bigint bigint::parse_decimal(const char *digits, size_t len)
+{
+    if (len <= (size_t) bigint::DECIMAL_DIGITS * bigint::CONVERSION_THRESHOLD)
+    {
+        // Horner's rule over 9 digit chunks, most significant chunk first
+        bigint ret;
+        ret.bignum.reserve(len / bigint::DECIMAL_DIGITS + 1);
+        size_t first = len % bigint::DECIMAL_DIGITS;
+        for (size_t st = 0, end = first ? first : bigint::DECIMAL_DIGITS; st < len; st = end, end += bigint::DECIMAL_DIGITS)
+        {
+            ret *= bigint::DECIMAL_BASE;
+            u_int64_t carry = bigint::parse_chunk(digits + st, end - st);
+            for (size_t idx = 0; carry; idx++)
+            {
+                if (idx == ret.num_digits())
+                    ret.bignum.emplace_back(0);
+                u_int64_t sum = ret.bignum[idx] + carry;
+                ret.bignum[idx] = sum % bigint::BASE;
+                carry = sum / bigint::BASE;
+            }
+        }
+
+        ret.pop_leading_zeros();
+        return ret;
+    }
+
+    // Split off the low 9 * 2^k digits, the largest such block shorter than the number
+    u_int32_t k = 0;
+    while (((size_t) bigint::DECIMAL_DIGITS << (k + 1)) < len)
+        k++;
+    size_t low_len = (size_t) bigint::DECIMAL_DIGITS << k;
+
+    bigint ret(bigint::parse_decimal(digits, len - low_len));
+    ret *= bigint::decimal_power(k);
+    ret += bigint::parse_decimal(digits + len - low_len, low_len);
+    return ret;
+}
+
+void bigint::write_decimal(const bigint &num, text_sink &out, size_t width)
+{
+    // Appends the magnitude of num, left padded with zeros to width digits
+    if (num.num_digits() <= bigint::CONVERSION_THRESHOLD)
+    {
+        bigint rest(num);
+        std::vector<u_int32_t> chunks;
+        do
+            chunks.emplace_back(bigint::div_small(rest, bigint::DECIMAL_BASE));
+        while (rest.num_digits() > 1 || rest.bignum[0]);
+
+        size_t top_len = bigint::chunk_length(chunks.back()), len = top_len + bigint::DECIMAL_DIGITS * (chunks.size() - 1);
+        char top[bigint::DECIMAL_DIGITS];
+        bigint::write_chunk(top, chunks.back());
+
+        for (size_t pad = width > len ? width - len : 0, step; pad; pad -= step)
+        {
+            step = std::min<size_t>(pad, bigint::DECIMAL_DIGITS);
+            memset(out.room(step), '0', step);
+        }
+        memcpy(out.room(top_len), top + bigint::DECIMAL_DIGITS - top_len, top_len);
+        for (auto it = chunks.rbegin() + 1; it != chunks.rend(); it++)
+            bigint::write_chunk(out.room(bigint::DECIMAL_DIGITS), *it);
+        return;
+    }
+
+    // Divide by the cached 10^(9 * 2^k) of about half the length of num
+    u_int32_t k = 0;
+    while (bigint::decimal_power(k + 1).num_digits() * 2 <= num.num_digits() + 1)
+        k++;
+    size_t low_width = (size_t) bigint::DECIMAL_DIGITS << k;
+
+    bigint quotient, remainder, magnitude(num);
+    magnitude.neg = false;
+    bigint::div_rem(magnitude, bigint::decimal_power(k), quotient, remainder);
+    bigint::write_decimal(quotient, out, width > low_width ? width - low_width : 0);
+    bigint::write_decimal(remainder, out, low_width);
+}
+
+const bigint &bigint::decimal_power(u_int32_t k)
+{
+    // 10^(9 * 2^k), squared up on demand and kept per thread
+    static thread_local std::deque<bigint> powers;
+    if (powers.empty())
+        powers.emplace_back(bigint::DECIMAL_BASE);
+    while (powers.size() <= k)
+        powers.emplace_back(powers.back() * powers.back());
+    return powers[k];
+}
+#else
+size_t bigint::decimal_length() const
+{
+    return this->neg + bigint::chunk_length(this->bignum.back()) + bigint::DECIMAL_DIGITS * (this->num_digits() - 1);
+}
+
+void bigint::write_limbs(char *out) const
 {
-    std::reverse(all(bignum));
+    if (this->neg)
+        *out++ = '-';
+
+    char top[bigint::DECIMAL_DIGITS];
+    size_t top_len = bigint::chunk_length(this->bignum.back());
+    bigint::write_chunk(top, this->bignum.back());
+    memcpy(out, top + bigint::DECIMAL_DIGITS - top_len, top_len);
+    out += top_len;
+
+    for (auto it = this->bignum.rbegin() + 1; it != this->bignum.rend(); it++, out += bigint::DECIMAL_DIGITS)
+        bigint::write_chunk(out, *it);
 }
+#endif
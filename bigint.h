@@ -1,76 +1,410 @@
-#ifndef __BIGINT_H__
-#define __BIGINT_H__
-
-
-#include "vector"
-#include "string"
-#include "deque"
-#include "iostream"
-#include "fstream"
-#include "iomanip"
-#include "cassert"
-#include "cstring"
-
-#define all(v) v.begin(), v.end()
-
-class bigint
-{
-private:
-    bool neg;
-    std::vector<u_int32_t> bignum;
-    static const int BASE = 1'000'000'000;
-
-    bool abs_greater_than(const bigint &num) const;
-    bool abs_lesser_than(const bigint &num) const;
-
-    static void add_with_shift(bigint &a, const bigint& b, u_int64_t sb);
-    static bigint _add_split(const bigint &a, u_int32_t st, u_int32_t end, u_int32_t split);
-    static void _sub(std::vector<u_int32_t> &a, const std::vector<u_int32_t> &b);
-    static void sub(bigint &a, const bigint &b);
-    static bigint multiply(const bigint &mul1, const bigint &mul2, u_int32_t m1_st, u_int32_t m1_end, u_int32_t m2_st, u_int32_t m2_end);
-    static void regular_multiplication(bigint &mul, const bigint &num);
-    bigint& operator*=(u_int32_t num);
-    bigint div_mod(const bigint &dividend, const bigint &divisor, bool div);
-    static u_int32_t div(bigint &dividend, bigint &div_cpy, const bigint &divisor, bool shift);
-    static void mul_dig_in_place(bigint &prod, const bigint &orig, u_int32_t digit);
-
-    void pop_leading_zeros();
-    void reverse_num();
-
-public:
-    bigint();
-    bigint(int64_t num);
-    bigint(const std::string& num);
-    bigint(const bigint &num);
-    bigint(const bigint &num, u_int32_t st, u_int32_t end);
-    bigint(const std::vector<u_int32_t> bnum, bool sign = false);
-    bigint(bigint &&num) noexcept;
-    bigint& operator=(const bigint &num);
-    bigint& operator=(bigint &&num) noexcept;
-    ~bigint();
-    
-    u_int64_t num_digits() const;
-    friend std::ostream& operator<<(std::ostream &o, const bigint &num);
-
-    bigint operator+(const bigint &num) const;
-    bigint operator-(const bigint &num) const;
-    bigint operator*(const bigint &num) const;
-    bigint operator/(const bigint &num) const;
-    bigint operator%(const bigint &num) const;
-
-    bool operator==(const bigint &num) const;
-    bool operator!=(const bigint &num) const;
-    bool operator>=(const bigint &num) const;
-    bool operator<=(const bigint &num) const;
-    bool operator>(const bigint &num) const;
-    bool operator<(const bigint &num) const;
-
-    bigint& operator+=(const bigint &num);
-    bigint& operator-=(const bigint &num);
-    bigint& operator*=(const bigint &num);
-    bigint& operator/=(const bigint &num);
-    bigint& operator%=(const bigint &num);
-};
-
-
-#endif
+#ifndef __BIGINT_H__
+#define __BIGINT_H__
+
+
+#include "vector"
+#include "string"
+#include "deque"
+#include "iostream"
+#include "fstream"
+#include "iomanip"
+#include "cassert"
+#include "cstring"
+#include "algorithm"
+#include "functional"
+#include "utility"
+#include "span"
+#include "charconv"
+#include "numeric"
+#include "cmath"
+#include "bit"
+#include "concepts"
+#include "type_traits"
+#include "limb_vector.h"
+#include "bigint_thresholds.h"
+#include "bigint_stats.h"
+
+#define all(v) v.begin(), v.end()
+
+// Crossovers come from bigint_thresholds.h, the tuning build makes them writable so one binary can time both sides
+#ifdef BIGINT_TUNE
+#define BIGINT_TUNABLE static inline u_int32_t
+#else
+#define BIGINT_TUNABLE static const u_int32_t
+#endif
+
+// bool and the character types are integral but not numbers, the machine integer operators reject them
+template <typename T>
+concept bigint_nonscalar = std::same_as<std::remove_cv_t<T>, bool> || std::same_as<std::remove_cv_t<T>, char>
+    || std::same_as<std::remove_cv_t<T>, wchar_t> || std::same_as<std::remove_cv_t<T>, char8_t>
+    || std::same_as<std::remove_cv_t<T>, char16_t> || std::same_as<std::remove_cv_t<T>, char32_t>;
+template <typename T>
+concept bigint_scalar = std::integral<T> && !bigint_nonscalar<T>;
+
+class bigint
+{
+    friend class bigint_divisor;
+    friend class bigint_view;
+#ifdef BIGINT_TUNE
+    friend class bigint_tune;
+#endif
+
+private:
+    bool neg;
+    limb_vector bignum;
+#ifdef BIGINT_BINARY_LIMBS
+    static constexpr u_int64_t BASE = 1ull << 32;
+#else
+    static constexpr u_int64_t BASE = 1'000'000'000;
+#endif
+    static constexpr u_int32_t DECIMAL_BASE = 1'000'000'000;
+    static constexpr u_int32_t DECIMAL_DIGITS = 9;
+    BIGINT_TUNABLE KARATSUBA_THRESHOLD = BIGINT_KARATSUBA_THRESHOLD;
+    BIGINT_TUNABLE TOOM3_THRESHOLD = BIGINT_TOOM3_THRESHOLD;
+    BIGINT_TUNABLE TOOM4_THRESHOLD = BIGINT_TOOM4_THRESHOLD;
+    BIGINT_TUNABLE NTT_THRESHOLD = BIGINT_NTT_THRESHOLD;
+    static const u_int32_t NTT_MAX_LENGTH = 1u << 26;
+    BIGINT_TUNABLE BZ_THRESHOLD = BIGINT_BZ_THRESHOLD;
+    BIGINT_TUNABLE NEWTON_THRESHOLD = BIGINT_NEWTON_THRESHOLD;
+    BIGINT_TUNABLE CONVERSION_THRESHOLD = BIGINT_CONVERSION_THRESHOLD;
+    static const u_int32_t CT_WINDOW = 4;
+    static const u_int32_t BINOMIAL_SIEVE_LIMIT = 1u << 27;
+    BIGINT_TUNABLE HGCD_THRESHOLD = BIGINT_HGCD_THRESHOLD;
+    static const size_t TEXT_BLOCK = 1 << 16;
+
+    // Per-modulus state for pow_mod: the modulus padded to n limbs plus either the Montgomery constants
+    // (inv = -mod^-1 mod BASE, r2 = BASE^2n mod mod) or Barrett's mu = BASE^2n / mod, and product scratch
+    struct mod_context
+    {
+        u_int32_t n, inv;
+        bool montgomery;
+        limb_vector mod, r2, mu, one;
+        limb_vector t, q, p;
+    };
+
+    bool abs_greater_than(const bigint &num) const;
+    bool abs_lesser_than(const bigint &num) const;
+
+    static void add_with_shift(bigint &a, const bigint& b, u_int64_t sb);
+    static void _sub(limb_vector &a, const limb_vector &b);
+    static bigint multiply(const bigint &mul1, const bigint &mul2, u_int32_t m1_st, u_int32_t m1_end, u_int32_t m2_st, u_int32_t m2_end);
+    static bigint unbalanced_multiply(const bigint &mul1, const bigint &mul2, u_int32_t m1_st, u_int32_t m1_end, u_int32_t m2_st, u_int32_t m2_end);
+    static bigint toom3_multiply(const bigint &mul1, const bigint &mul2, u_int32_t m1_st, u_int32_t m1_end, u_int32_t m2_st, u_int32_t m2_end);
+    static bigint toom4_multiply(const bigint &mul1, const bigint &mul2, u_int32_t m1_st, u_int32_t m1_end, u_int32_t m2_st, u_int32_t m2_end);
+    static bigint ntt_multiply(const bigint &mul1, const bigint &mul2, u_int32_t m1_st, u_int32_t m1_end, u_int32_t m2_st, u_int32_t m2_end);
+    template <u_int32_t MOD, u_int32_t ROOT>
+    static std::vector<u_int32_t> ntt_convolve(const bigint &mul1, const bigint &mul2, u_int32_t m1_st, u_int32_t m1_end, u_int32_t m2_st, u_int32_t m2_end, u_int32_t size);
+    template <u_int32_t MOD, u_int32_t ROOT>
+    static void ntt_transform(std::vector<u_int32_t> &a, bool invert);
+    static void karatsuba_kernel(u_int32_t *r, const u_int32_t *a, u_int32_t na, const u_int32_t *b, u_int32_t nb, u_int32_t *scratch);
+    static u_int32_t add_halves(u_int32_t *r, const u_int32_t *a, u_int32_t h, u_int32_t n);
+    static void add_limbs(u_int32_t *a, u_int32_t na, const u_int32_t *b, u_int32_t nb);
+    static void sub_limbs(u_int32_t *a, u_int32_t na, const u_int32_t *b, u_int32_t nb);
+    static u_int32_t karatsuba_scratch(u_int32_t n);
+    static u_int32_t* scratch_arena(u_int32_t limbs);
+    static void run_parallel(u_int32_t len, std::vector<std::function<void()>> &jobs);
+    static u_int32_t mod_pow_u32(u_int64_t base, u_int64_t exp, u_int32_t mod);
+    static bigint split_piece(const bigint &num, u_int32_t st, u_int32_t end, u_int32_t limit);
+    static bigint signed_multiply(const bigint &a, const bigint &b);
+    static bigint product_tree(std::vector<bigint> &terms, size_t st, size_t end);
+    static bigint root_newton(const bigint &a, u_int32_t k, bigint &power);
+    static long double log_abs(const bigint &a);
+    static u_int32_t mod_u32(const bigint &a, u_int32_t d);
+    static void mod_u32_batch(const bigint &a, const u_int32_t *d, size_t count, u_int32_t *r);
+    static bool is_prime_u32(u_int32_t q);
+    static void gcd_reduce(bigint &a, bigint &b, bigint *sa, bigint *sb);
+    static void hgcd(bigint &a, bigint &b, bigint (&m)[4]);
+    static bool lehmer_step(bigint &a, bigint &b, int64_t (&m)[4]);
+    static void lehmer_combine(u_int32_t *r, const u_int32_t *x, u_int32_t px, const u_int32_t *y, u_int32_t py, u_int32_t n);
+    static void hgcd_lift(bigint &a, bigint &b, u_int32_t p, bigint (&m)[4]);
+    static void gcd_normalize(bigint &a, bigint &b, bigint (&m)[4]);
+    static void apply_matrix(bigint &x, bigint &y, const bigint &m00, const bigint &m01, const bigint &m10, const bigint &m11);
+    static void batch_run(size_t count, u_int64_t limbs, const std::function<void(size_t, size_t)> &chunk);
+    static size_t batch_chunks(size_t count);
+    static u_int64_t batch_limbs(std::span<const bigint> terms);
+
+    // Layout of save's output, 16 bytes ahead of the limbs. radix is 0 for base 10^9 limbs and 1 for base 2^32
+    struct file_header
+    {
+        char magic[4];
+        u_int16_t version;
+        u_int8_t radix;
+        u_int8_t sign;
+        u_int64_t limbs;
+    };
+    static const u_int16_t FILE_VERSION = 1;
+    static constexpr size_t LOAD_BLOCK = 1 << 16;
+    static u_int8_t file_radix();
+    static bool valid_header(const file_header &header);
+    static bool valid_limbs(const u_int32_t *limbs, size_t n, u_int8_t radix);
+    static void file_order(file_header &header);
+    static void file_order(u_int32_t *limbs, size_t n);
+    static bigint rebase(const u_int32_t *limbs, size_t n, const std::vector<bigint> &powers);
+    static bigint from_radix(const u_int32_t *limbs, size_t n, u_int64_t radix);
+
+    // Decimal digits in arrival order, gathered into base 10^9 groups most significant first
+    struct digit_reader
+    {
+        limb_vector groups;
+        u_int32_t partial = 0, partial_len = 0;
+
+        void feed(const char *digits, size_t len);
+        bool empty() const;
+        bigint finish(bool negative);
+    };
+
+    // Fixed block that decimal output is formatted into, handed to flush each time it fills
+    struct text_sink
+    {
+        std::function<bool(const char*, size_t)> flush;
+        std::vector<char> block = std::vector<char>(TEXT_BLOCK);
+        size_t used = 0;
+        bool ok = true;
+
+        char* room(size_t len);
+        bool finish();
+    };
+    void write_text(text_sink &out) const;
+    static bool same_range(const bigint &mul1, const bigint &mul2, u_int32_t m1_st, u_int32_t m1_end, u_int32_t m2_st, u_int32_t m2_end);
+    static void signed_add(bigint &a, const bigint &b, bool negate);
+    static void div_small_exact(bigint &a, u_int32_t d);
+    void add_small(bool negative, u_int64_t mag);
+    void mul_small(bool negative, u_int64_t mag);
+    u_int64_t divide_small(bool negative, u_int64_t mag);
+    u_int64_t mod_small(u_int64_t mag) const;
+    int compare_small(bool negative, u_int64_t mag) const;
+    bool small_magnitude(u_int64_t &mag) const;
+    static bigint from_magnitude(bool negative, u_int64_t mag);
+    template <bigint_scalar T>
+    static bool scalar_negative(T num)
+    {
+        if constexpr (std::is_signed_v<T>)
+            return num < 0;
+        return false;
+    }
+    template <bigint_scalar T>
+    static u_int64_t scalar_magnitude(T num)
+    {
+        return bigint::scalar_negative(num) ? -(u_int64_t) num : (u_int64_t) num;
+    }
+    bigint div_mod(const bigint &dividend, const bigint &divisor, bool div);
+    static void div_rem(const bigint &dividend, const bigint &divisor, bigint &quotient, bigint &remainder);
+    static void knuth_divide(const bigint &dividend, const bigint &divisor, bigint &quotient, bigint &remainder);
+    static void knuth_core(u_int32_t *u, u_int32_t m, const u_int32_t *v, u_int32_t n, u_int64_t v_inv, u_int32_t *q);
+    static void bz_divide(const bigint &dividend, const bigint &divisor, bigint &quotient, bigint &remainder);
+    static void bz_div_2n1n(const bigint &a, const bigint &b, u_int32_t n, bigint &quotient, bigint &remainder);
+    static void bz_div_3n2n(const bigint &a, const bigint &b, u_int32_t h, bigint &quotient, bigint &remainder);
+    static void newton_divide(const bigint &dividend, const bigint &divisor, bigint &quotient, bigint &remainder);
+    static bigint reciprocal(const bigint &d);
+    static limb_vector barrett_inverse(const bigint &d);
+    static u_int32_t div_small(bigint &a, u_int32_t d);
+    static u_int32_t div_limb(u_int32_t *q, const u_int32_t *a, size_t n, u_int32_t d, u_int64_t d_inv);
+    static u_int64_t mod_wide(const u_int32_t *a, size_t n, u_int64_t d);
+    static void shift_limbs(bigint &a, int64_t limbs);
+
+    static void mod_setup(mod_context &ctx, const bigint &mod, bool montgomery);
+    static void mod_mul(mod_context &ctx, u_int32_t *r, const u_int32_t *a, const u_int32_t *b);
+    static void mont_mul(mod_context &ctx, u_int32_t *r, const u_int32_t *a, const u_int32_t *b);
+    static void mod_reduce_base(mod_context &ctx, const bigint &base, u_int32_t *r);
+    static bigint mod_result(mod_context &ctx, const u_int32_t *x);
+    static std::vector<u_int8_t> exponent_bits(const bigint &exp, bool padded);
+    static u_int32_t inverse_mod_base(u_int32_t a);
+    static int compare_limbs(const u_int32_t *a, const u_int32_t *b, size_t n);
+
+    static u_int32_t parse_chunk(const char *digits, size_t len);
+    static void write_chunk(char *out, u_int32_t chunk);
+    static size_t chunk_length(u_int32_t chunk);
+#ifdef BIGINT_BINARY_LIMBS
+    static bigint parse_decimal(const char *digits, size_t len);
+    static void write_decimal(const bigint &num, text_sink &out, size_t width);
+    static const bigint& decimal_power(u_int32_t k);
+#else
+    size_t decimal_length() const;
+    void write_limbs(char *out) const;
+#endif
+
+    void pop_leading_zeros();
+
+public:
+    bigint();
+    bigint(int64_t num);
+    bigint(const std::string& num);
+    bigint(const bigint &num);
+    bigint(const bigint &num, u_int32_t st, u_int32_t end);
+    bigint(const std::vector<u_int32_t> bnum, bool sign = false);
+    bigint(bigint &&num) noexcept;
+    bigint& operator=(const bigint &num);
+    bigint& operator=(bigint &&num) noexcept;
+    ~bigint();
+    
+    u_int64_t num_digits() const;
+    static void set_threads(u_int32_t threads);
+    static u_int32_t get_threads();
+    static void set_parallel_threshold(u_int32_t limbs);
+    std::string to_string() const;
+    // Versioned binary format: the "BGNT" magic, format version, limb radix, sign and limb count, then the limbs as
+    // little-endian 32-bit words from the least significant. load takes either radix and converts if needed, a stream
+    // that does not hold a valid value is left with failbit set
+    void save(std::ostream &out) const;
+    static bigint load(std::istream &in);
+    std::to_chars_result to_chars(char *first, char *last) const;
+    friend std::ostream& operator<<(std::ostream &o, const bigint &num);
+    friend std::istream& operator>>(std::istream &i, bigint &num);
+    // Decimal text through blocks of TEXT_BLOCK characters, so neither direction holds the whole text. read takes an
+    // optional '-' and the digits after it, past leading whitespace; a stream keeps the character that ends them, a
+    // descriptor may only hold whitespace after them. write formats 9-digit groups straight into the block
+    static bool read(std::istream &in, bigint &num);
+    static bool read(int fd, bigint &num);
+    bool write(std::ostream &out) const;
+    bool write(int fd) const;
+
+    bigint operator+(const bigint &num) const;
+    bigint operator-(const bigint &num) const;
+    bigint operator*(const bigint &num) const;
+    bigint operator/(const bigint &num) const;
+    bigint operator%(const bigint &num) const;
+    bigint square() const;
+    // base^exp mod mod for exp >= 0 and mod > 0, the result is in [0, mod). pow_mod_ct runs in time that does not
+    // depend on the exponent's value (only its limb count) and needs mod coprime to the limb base, e.g. an RSA modulus
+    static bigint pow_mod(const bigint &base, const bigint &exp, const bigint &mod);
+    static bigint pow_mod_ct(const bigint &base, const bigint &exp, const bigint &mod);
+    // base^exp, n!, n choose k (zero for k > n) and the product of a range of values convertible to bigint (one
+    // for an empty range). Each is a tree of balanced products, so the large ones reach the fast multiply tiers
+    static bigint pow(const bigint &base, u_int64_t exp);
+    static bigint factorial(u_int32_t n);
+    static bigint binomial(u_int32_t n, u_int32_t k);
+    template <class It>
+    static bigint product(It first, It last)
+    {
+        std::vector<bigint> terms(first, last);
+        return bigint::product_tree(terms, 0, terms.size());
+    }
+    // Floor of the square root and of the k-th root (k >= 1), a negative value only has odd roots which truncate towards
+    // zero. Zero and one count as perfect powers, a negative value only as an odd one
+    static bigint isqrt(const bigint &a);
+    static bigint iroot(const bigint &a, u_int32_t k);
+    static bool is_perfect_square(const bigint &a);
+    static bool is_perfect_power(const bigint &a);
+    // gcd(a, b) >= 0, xgcd also finds s and t with s a + t b = gcd (|s| <= |b| / 2gcd, as small as mpz_gcdext's),
+    // mod_inverse is a^-1 in [0, m) for m > 0, or zero when gcd(a, m) != 1
+    static bigint gcd(const bigint &a, const bigint &b);
+    static bigint xgcd(const bigint &a, const bigint &b, bigint &s, bigint &t);
+    static bigint mod_inverse(const bigint &a, const bigint &m);
+    // Element-wise out[i] = a[i] + b[i], a[i] * b[i] and a[i] % m[i] (or % one shared modulus) over spans of equal length,
+    // and the sum and product of a span. With set_threads the batch is cut into chunks the pool's threads claim in turn;
+    // results are exactly the scalar operators' and out may be one of the inputs
+    static void batch_add(std::span<const bigint> a, std::span<const bigint> b, std::span<bigint> out);
+    static void batch_mul(std::span<const bigint> a, std::span<const bigint> b, std::span<bigint> out);
+    static void batch_mod(std::span<const bigint> a, std::span<const bigint> m, std::span<bigint> out);
+    static void batch_mod(std::span<const bigint> a, const bigint &m, std::span<bigint> out);
+    static bigint sum(std::span<const bigint> terms);
+    static bigint product(std::span<const bigint> terms);
+
+    bool operator==(const bigint &num) const;
+    bool operator!=(const bigint &num) const;
+    bool operator>=(const bigint &num) const;
+    bool operator<=(const bigint &num) const;
+    bool operator>(const bigint &num) const;
+    bool operator<(const bigint &num) const;
+
+    bigint& operator+=(const bigint &num);
+    bigint& operator-=(const bigint &num);
+    bigint& operator*=(const bigint &num);
+    bigint& operator/=(const bigint &num);
+    bigint& operator%=(const bigint &num);
+
+    // Machine integer operands run on the limbs without becoming a bigint first: + and - stop with the last carry,
+    // * and / by less than the limb base are one mul_1 or division pass, % only reads the limbs, and the comparisons
+    // look at no more than the top three. Wider multipliers and divisors cost a pass per limb of theirs. Results and
+    // signs are those of the bigint operators
+    template <bigint_scalar T>
+    bigint& operator+=(T num)
+    {
+        this->add_small(bigint::scalar_negative(num), bigint::scalar_magnitude(num));
+        return *this;
+    }
+    template <bigint_scalar T>
+    bigint& operator-=(T num)
+    {
+        this->add_small(!bigint::scalar_negative(num), bigint::scalar_magnitude(num));
+        return *this;
+    }
+    template <bigint_scalar T>
+    bigint& operator*=(T num)
+    {
+        this->mul_small(bigint::scalar_negative(num), bigint::scalar_magnitude(num));
+        return *this;
+    }
+    template <bigint_scalar T>
+    bigint& operator/=(T num)
+    {
+        this->divide_small(bigint::scalar_negative(num), bigint::scalar_magnitude(num));
+        return *this;
+    }
+    template <bigint_scalar T>
+    bigint& operator%=(T num)
+    {
+        *this = bigint::from_magnitude(this->neg, this->mod_small(bigint::scalar_magnitude(num)));
+        return *this;
+    }
+    template <bigint_scalar T>
+    bigint operator+(T num) const { return bigint(*this) += num; }
+    template <bigint_scalar T>
+    bigint operator-(T num) const { return bigint(*this) -= num; }
+    template <bigint_scalar T>
+    bigint operator*(T num) const { return bigint(*this) *= num; }
+    template <bigint_scalar T>
+    bigint operator/(T num) const { return bigint(*this) /= num; }
+    template <bigint_scalar T>
+    bigint operator%(T num) const { return bigint::from_magnitude(this->neg, this->mod_small(bigint::scalar_magnitude(num))); }
+    template <bigint_scalar T>
+    bool operator==(T num) const { return !this->compare_small(bigint::scalar_negative(num), bigint::scalar_magnitude(num)); }
+    template <bigint_scalar T>
+    bool operator!=(T num) const { return this->compare_small(bigint::scalar_negative(num), bigint::scalar_magnitude(num)); }
+    template <bigint_scalar T>
+    bool operator<(T num) const { return this->compare_small(bigint::scalar_negative(num), bigint::scalar_magnitude(num)) < 0; }
+    template <bigint_scalar T>
+    bool operator>(T num) const { return this->compare_small(bigint::scalar_negative(num), bigint::scalar_magnitude(num)) > 0; }
+    template <bigint_scalar T>
+    bool operator<=(T num) const { return this->compare_small(bigint::scalar_negative(num), bigint::scalar_magnitude(num)) <= 0; }
+    template <bigint_scalar T>
+    bool operator>=(T num) const { return this->compare_small(bigint::scalar_negative(num), bigint::scalar_magnitude(num)) >= 0; }
+    // Without these a bool or character would still convert to bigint and take part as a number
+    template <bigint_nonscalar T> bigint& operator+=(T) = delete;
+    template <bigint_nonscalar T> bigint& operator-=(T) = delete;
+    template <bigint_nonscalar T> bigint& operator*=(T) = delete;
+    template <bigint_nonscalar T> bigint& operator/=(T) = delete;
+    template <bigint_nonscalar T> bigint& operator%=(T) = delete;
+    template <bigint_nonscalar T> bigint operator+(T) const = delete;
+    template <bigint_nonscalar T> bigint operator-(T) const = delete;
+    template <bigint_nonscalar T> bigint operator*(T) const = delete;
+    template <bigint_nonscalar T> bigint operator/(T) const = delete;
+    template <bigint_nonscalar T> bigint operator%(T) const = delete;
+    template <bigint_nonscalar T> bool operator==(T) const = delete;
+    template <bigint_nonscalar T> bool operator!=(T) const = delete;
+    template <bigint_nonscalar T> bool operator<(T) const = delete;
+    template <bigint_nonscalar T> bool operator>(T) const = delete;
+    template <bigint_nonscalar T> bool operator<=(T) const = delete;
+    template <bigint_nonscalar T> bool operator>=(T) const = delete;
+
+    /*
+     * Limb span kernels: the routines the operators are built from, exposed so hot loops can run on
+     * caller-owned buffers. Spans are little-endian limbs below limb_base(), the result may alias an
+     * input in the element-wise routines but not in mul_basecase and sqr_basecase. Each returns the
+     * carry (or borrow) limb out of the top of r.
+     */
+    static constexpr u_int64_t limb_base() { return BASE; }
+    static u_int32_t add_n(u_int32_t *r, const u_int32_t *a, const u_int32_t *b, size_t n);
+    static u_int32_t sub_n(u_int32_t *r, const u_int32_t *a, const u_int32_t *b, size_t n);
+    static u_int32_t add_1(u_int32_t *r, const u_int32_t *a, size_t n, u_int32_t b);
+    static u_int32_t sub_1(u_int32_t *r, const u_int32_t *a, size_t n, u_int32_t b);
+    static u_int32_t mul_1(u_int32_t *r, const u_int32_t *a, size_t n, u_int32_t b);
+    static u_int32_t addmul_1(u_int32_t *r, const u_int32_t *a, size_t n, u_int32_t b);
+    static u_int32_t submul_1(u_int32_t *r, const u_int32_t *a, size_t n, u_int32_t b);
+    // r[0 .. na + nb) = a * b and r[0 .. 2n) = a^2, with na, nb, n >= 1
+    static void mul_basecase(u_int32_t *r, const u_int32_t *a, size_t na, const u_int32_t *b, size_t nb);
+    static void sqr_basecase(u_int32_t *r, const u_int32_t *a, size_t n);
+};
+
+
+#endif
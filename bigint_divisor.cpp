@@ -0,0 +1,182 @@
+#include "bigint_divisor.h"
+
+
+/*Constructors*/
+bigint_divisor::bigint_divisor(const bigint &divisor) : d(divisor), n(divisor.num_digits()), scale(1), inv(0), scale_inv(0)
+{
+    assert(n > 1 || d.bignum[0]);
+
+    if (n == 1)
+    {
+        inv = UINT64_MAX / d.bignum[0];
+        return;
+    }
+
+    if (n < bigint_divisor::BARRETT_THRESHOLD)
+    {
+        // Knuth's normalization: scale so the top divisor limb is at least BASE / 2
+        scale = bigint::BASE / ((u_int64_t) d.bignum[n - 1] + 1);
+        scale_inv = UINT64_MAX / scale;
+        v.assign(d.bignum.begin(), d.bignum.end());
+        [[maybe_unused]] u_int32_t carry = bigint::mul_1(v.data(), v.data(), n, scale);
+        assert(!carry && v[n - 1] >= bigint::BASE / 2);
+        inv = UINT64_MAX / v[n - 1];
+        return;
+    }
+
+    mu = bigint::barrett_inverse(d);
+    w.assign(2 * n, 0);
+    p.assign(2 * n + 2, 0);
+    t.assign(2 * n, 0);
+}
+
+
+/*Public helpers*/
+const bigint& bigint_divisor::divisor() const
+{
+    return d;
+}
+
+bigint bigint_divisor::div(const bigint &a)
+{
+    bigint quotient;
+    this->divmod(a, quotient, spare);
+    return quotient;
+}
+
+bigint bigint_divisor::mod(const bigint &a)
+{
+    bigint remainder;
+    this->divmod(a, spare, remainder);
+    return remainder;
+}
+
+void bigint_divisor::divmod(const bigint &a, bigint &quotient, bigint &remainder)
+{
+    if (&a == &quotient || &a == &remainder)
+    {
+        bigint copy(a);
+        this->divmod(copy, quotient, remainder);
+        return;
+    }
+
+    if (d.abs_greater_than(a))
+    {
+        quotient = bigint(0);
+        remainder = a;
+        return;
+    }
+
+    if (n == 1)
+    {
+        BIGINT_STAT_PATH(DIVISOR_LIMB);
+        quotient.bignum = a.bignum;
+        u_int32_t rem = bigint::div_limb(quotient.bignum.data(), quotient.bignum.data(), quotient.num_digits(), d.bignum[0], inv);
+        quotient.pop_leading_zeros();
+        remainder.bignum.assign(1, rem);
+    }
+    else if (n < bigint_divisor::BARRETT_THRESHOLD)
+    {
+        BIGINT_STAT_PATH(DIVISOR_KNUTH);
+        this->knuth_divmod(a, quotient, remainder);
+    }
+    else
+    {
+        BIGINT_STAT_PATH(DIVISOR_BARRETT);
+        this->barrett_divmod(a, quotient, remainder);
+    }
+
+    quotient.neg = d.neg ^ a.neg;
+    remainder.neg = a.neg && !(remainder.num_digits() == 1 && !remainder.bignum[0]);
+}
+
+
+/*Private helpers*/
+void bigint_divisor::knuth_divmod(const bigint &a, bigint &quotient, bigint &remainder)
+{
+    // Algorithm D on the cached normalized divisor, the remainder is scaled back with the cached reciprocal
+    u_int32_t len = a.num_digits(), m = len - n;
+    limb_vector &u = remainder.bignum;
+    u.reserve(len + 1);
+    u.assign(a.bignum.begin(), a.bignum.end());
+    u.emplace_back(bigint::mul_1(u.data(), u.data(), len, scale));
+
+    quotient.bignum.assign(m + 1, 0);
+    bigint::knuth_core(u.data(), m, v.data(), n, inv, quotient.bignum.data());
+    quotient.pop_leading_zeros();
+
+    u.resize(n);
+    if (scale > 1)
+        bigint::div_limb(u.data(), u.data(), n, scale, scale_inv);
+    remainder.pop_leading_zeros();
+}
+
+void bigint_divisor::barrett_divmod(const bigint &a, bigint &quotient, bigint &remainder)
+{
+    // Reduce n limbs at a time from the top. The first window takes up to 2n limbs as long as it stays
+    // below |d| * BASE^n, every later one is the running remainder followed by the next n limbs
+    u_int32_t len = a.num_digits(), k = len > 2 * n ? (len - n - 1) / n : 0, top = len - k * n;
+    if (top == 2 * n && bigint::compare_limbs(a.bignum.data() + len - n, d.bignum.data(), n) >= 0)
+    {
+        k++;
+        top -= n;
+    }
+
+    std::fill(w.begin(), w.end(), 0);
+    std::copy(a.bignum.begin() + k * n, a.bignum.end(), w.begin());
+    quotient.bignum.assign((k + 1) * n, 0);
+    for (u_int32_t j = k; ; j--)
+    {
+        this->barrett_step(quotient.bignum.data() + j * n);
+        if (!j)
+            break;
+
+        std::copy(w.begin(), w.begin() + n, w.begin() + n);
+        std::copy(a.bignum.begin() + (j - 1) * n, a.bignum.begin() + j * n, w.begin());
+    }
+
+    quotient.pop_leading_zeros();
+    remainder.bignum.assign(w.begin(), w.begin() + n);
+    remainder.pop_leading_zeros();
+}
+
+void bigint_divisor::barrett_step(u_int32_t *q)
+{
+    // w < |d| * BASE^n: q[0 .. n) = w / |d| and w[0 .. n) = w mod |d|. The estimate
+    // (w / BASE^(n - 1)) * mu / BASE^(n + 1) is at most three short, so w - qe * d only needs n + 1 limbs
+    const u_int32_t *dv = d.bignum.data();
+    bigint_divisor::multiply(p.data(), w.data() + n - 1, n + 1, mu.data(), n + 1);
+    u_int32_t *qe = p.data() + n + 1;
+    assert(!qe[n]);
+
+    bigint_divisor::multiply(t.data(), qe, n, dv, n);
+    bigint::sub_n(w.data(), w.data(), t.data(), n + 1);
+    while (w[n] || bigint::compare_limbs(w.data(), dv, n) >= 0)
+    {
+        w[n] -= bigint::sub_n(w.data(), w.data(), dv, n);
+        bigint::add_1(qe, qe, n, 1);
+    }
+
+    std::copy(qe, qe + n, q);
+}
+
+void bigint_divisor::multiply(u_int32_t *r, const u_int32_t *a, u_int32_t na, const u_int32_t *b, u_int32_t nb)
+{
+    // r[0 .. na + nb) = a * b, Karatsuba-sized operands stay on the span kernel and larger ones take the
+    // Toom and NTT dispatch of operator*
+    if (std::max(na, nb) < bigint::TOOM3_THRESHOLD)
+    {
+        bigint::karatsuba_kernel(r, a, na, b, nb, bigint::scratch_arena(bigint::karatsuba_scratch(std::max(na, nb))));
+        return;
+    }
+
+    bigint x, y;
+    x.bignum.assign(a, a + na);
+    y.bignum.assign(b, b + nb);
+    x.pop_leading_zeros();
+    y.pop_leading_zeros();
+
+    bigint prod(x * y);
+    std::fill(r, r + na + nb, 0);
+    std::copy(prod.bignum.begin(), prod.bignum.end(), r);
+}
@@ -0,0 +1,46 @@
+#ifndef __BIGINT_DIVISOR_H__
+#define __BIGINT_DIVISOR_H__
+
+
+#include "bigint.h"
+
+/*
+ * A divisor prepared once for many divisions by the same value. A one-limb divisor keeps a 64-bit
+ * reciprocal. Below BARRETT_THRESHOLD limbs it keeps Knuth's normalized divisor and a reciprocal of its
+ * top limb, so no trial quotient needs a hardware division. Longer divisors keep Barrett's
+ * mu = BASE^(2n) / |d|: a dividend of up to 2n - 1 limbs then costs two multiplications plus a couple of
+ * corrections, and longer dividends cost two per n limbs. Results match operator/ and operator%. The
+ * working limbs live in the object, so one instance must not be shared between threads.
+ */
+class bigint_divisor
+{
+#ifdef BIGINT_TUNE
+    friend class bigint_tune;
+#endif
+
+private:
+    BIGINT_TUNABLE BARRETT_THRESHOLD = BIGINT_BARRETT_THRESHOLD;
+
+    bigint d;
+    u_int32_t n, scale;
+    u_int64_t inv, scale_inv;
+    limb_vector v, mu;
+    limb_vector w, p, t;
+    bigint spare;
+
+    void knuth_divmod(const bigint &a, bigint &quotient, bigint &remainder);
+    void barrett_divmod(const bigint &a, bigint &quotient, bigint &remainder);
+    void barrett_step(u_int32_t *q);
+    static void multiply(u_int32_t *r, const u_int32_t *a, u_int32_t na, const u_int32_t *b, u_int32_t nb);
+
+public:
+    explicit bigint_divisor(const bigint &divisor);
+
+    const bigint& divisor() const;
+    bigint div(const bigint &a);
+    bigint mod(const bigint &a);
+    void divmod(const bigint &a, bigint &quotient, bigint &remainder);
+};
+
+
+#endif
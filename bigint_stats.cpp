@@ -0,0 +1,193 @@
+#include "bigint_stats.h"
+#include "atomic"
+#include "mutex"
+#include "vector"
+#include "chrono"
+#include "bit"
+#include "iostream"
+#include "iomanip"
+#if defined(__x86_64__)
+#include "x86intrin.h"
+#endif
+
+
+// Slot layout of a block: calls, size histograms, paths, allocations and bytes, kernel calls, kernel cycles
+static const u_int32_t SIZES_AT = bigint_stats::OP_COUNT;
+static const u_int32_t PATHS_AT = SIZES_AT + bigint_stats::OP_COUNT * bigint_stats::SIZE_BUCKETS;
+static const u_int32_t ALLOCS_AT = PATHS_AT + bigint_stats::PATH_COUNT;
+static const u_int32_t KERNELS_AT = ALLOCS_AT + 2;
+static const u_int32_t CYCLES_AT = KERNELS_AT + bigint_stats::KERNEL_COUNT;
+
+static const char *op_names[] = {"add", "sub", "mul", "sqr", "div", "pow_mod", "gcd", "parse", "format"};
+static const char *path_names[] = {
+    "mul basecase", "mul karatsuba", "mul unbalanced", "mul toom3", "mul toom4", "mul ntt",
+    "div limb", "div knuth", "div burnikel-ziegler", "div newton", "divisor limb", "divisor knuth", "divisor barrett",
+    "gcd half-gcd", "gcd lehmer", "gcd divide"};
+static const char *kernel_names[] = {"add_n", "sub_n", "mul_1", "addmul_1", "submul_1", "mul_basecase", "sqr_basecase", "knuth_core", "ntt_transform"};
+
+// Only the owning thread writes a block, so a relaxed load and store count without a locked instruction
+struct bigint_stats::block
+{
+    std::atomic<u_int64_t> slot[bigint_stats::SLOTS] = {};
+};
+
+// Blocks outlive their threads so that counts of finished threads stay in the totals, reset() moves the baseline
+struct bigint_stats::registry
+{
+    std::mutex lock;
+    std::vector<block*> blocks;
+    std::array<u_int64_t, bigint_stats::SLOTS> baseline{};
+};
+
+
+/*Snapshots*/
+bigint_stats::counters bigint_stats::snapshot()
+{
+    std::array<u_int64_t, SLOTS> t = bigint_stats::totals();
+    counters c;
+    for (u_int32_t o = 0; o < OP_COUNT; o++)
+    {
+        c.calls[o] = t[o];
+        for (u_int32_t k = 0; k < SIZE_BUCKETS; k++)
+            c.sizes[o][k] = t[SIZES_AT + o * SIZE_BUCKETS + k];
+    }
+    for (u_int32_t p = 0; p < PATH_COUNT; p++)
+        c.paths[p] = t[PATHS_AT + p];
+    c.allocations = t[ALLOCS_AT];
+    c.allocated_bytes = t[ALLOCS_AT + 1];
+    for (u_int32_t k = 0; k < KERNEL_COUNT; k++)
+    {
+        c.kernel_calls[k] = t[KERNELS_AT + k];
+        c.kernel_cycles[k] = t[CYCLES_AT + k];
+    }
+    return c;
+}
+
+void bigint_stats::reset()
+{
+    std::array<u_int64_t, SLOTS> t = bigint_stats::totals();
+    registry &r = bigint_stats::shared();
+    std::lock_guard<std::mutex> guard(r.lock);
+    for (u_int32_t s = 0; s < SLOTS; s++)
+        r.baseline[s] += t[s];
+}
+
+void bigint_stats::dump(std::ostream &out)
+{
+    bigint_stats::dump(out, bigint_stats::snapshot());
+}
+
+void bigint_stats::dump(std::ostream &out, const counters &c)
+{
+#ifndef BIGINT_STATS
+    out << "bigint stats: not compiled in, build with -DBIGINT_STATS\n";
+#endif
+    // Size buckets print as the smallest operand length they hold
+    out << "op        calls  sizes (limbs >= : calls)\n";
+    for (u_int32_t o = 0; o < OP_COUNT; o++)
+    {
+        if (!c.calls[o])
+            continue;
+        out << std::left << std::setw(8) << op_names[o] << std::right << std::setw(8) << c.calls[o] << " ";
+        for (u_int32_t k = 0; k < SIZE_BUCKETS; k++)
+        {
+            if (c.sizes[o][k])
+                out << " " << (k ? 1ull << (k - 1) : 0) << ": " << c.sizes[o][k];
+        }
+        out << "\n";
+    }
+
+    out << "path                         count\n";
+    for (u_int32_t p = 0; p < PATH_COUNT; p++)
+    {
+        if (c.paths[p])
+            out << std::left << std::setw(22) << path_names[p] << std::right << std::setw(12) << c.paths[p] << "\n";
+    }
+
+    out << "allocations " << c.allocations << ", " << c.allocated_bytes << " bytes\n";
+    out << "kernel              calls          cycles  cycles/call\n";
+    for (u_int32_t k = 0; k < KERNEL_COUNT; k++)
+    {
+        if (!c.kernel_calls[k])
+            continue;
+        out << std::left << std::setw(14) << kernel_names[k] << std::right << std::setw(12) << c.kernel_calls[k] << std::setw(16)
+            << c.kernel_cycles[k] << std::setw(13) << c.kernel_cycles[k] / c.kernel_calls[k] << "\n";
+    }
+}
+
+
+/*Counting*/
+void bigint_stats::count_op(op o, u_int64_t limbs)
+{
+    bigint_stats::add(o, 1);
+    bigint_stats::add(SIZES_AT + o * SIZE_BUCKETS + std::min<u_int32_t>(std::bit_width(limbs), SIZE_BUCKETS - 1), 1);
+}
+
+void bigint_stats::count_path(path p)
+{
+    bigint_stats::add(PATHS_AT + p, 1);
+}
+
+void bigint_stats::count_alloc(size_t bytes)
+{
+    bigint_stats::add(ALLOCS_AT, 1);
+    bigint_stats::add(ALLOCS_AT + 1, bytes);
+}
+
+void bigint_stats::count_kernel(kernel k, u_int64_t cycles)
+{
+    bigint_stats::add(KERNELS_AT + k, 1);
+    bigint_stats::add(CYCLES_AT + k, cycles);
+}
+
+u_int64_t bigint_stats::cycles()
+{
+    // The time stamp counter where there is one, nanoseconds elsewhere
+#if defined(__x86_64__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+
+/*Private helpers*/
+bigint_stats::block& bigint_stats::local()
+{
+    thread_local block *mine = nullptr;
+    if (!mine)
+    {
+        mine = new block;
+        registry &r = bigint_stats::shared();
+        std::lock_guard<std::mutex> guard(r.lock);
+        r.blocks.emplace_back(mine);
+    }
+    return *mine;
+}
+
+bigint_stats::registry& bigint_stats::shared()
+{
+    static registry r;
+    return r;
+}
+
+void bigint_stats::add(u_int32_t slot, u_int64_t value)
+{
+    std::atomic<u_int64_t> &s = bigint_stats::local().slot[slot];
+    s.store(s.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+std::array<u_int64_t, bigint_stats::SLOTS> bigint_stats::totals()
+{
+    registry &r = bigint_stats::shared();
+    std::lock_guard<std::mutex> guard(r.lock);
+    std::array<u_int64_t, SLOTS> t{};
+    for (const block *b : r.blocks)
+    {
+        for (u_int32_t s = 0; s < SLOTS; s++)
+            t[s] += b->slot[s].load(std::memory_order_relaxed);
+    }
+    for (u_int32_t s = 0; s < SLOTS; s++)
+        t[s] -= r.baseline[s];
+    return t;
+}
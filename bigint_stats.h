@@ -0,0 +1,90 @@
+#ifndef __BIGINT_STATS_H__
+#define __BIGINT_STATS_H__
+
+
+#include "sys/types.h"
+#include "cstddef"
+#include "array"
+#include "iosfwd"
+
+/*
+ * Counters for where bigint spends its time, compiled in with -DBIGINT_STATS (make STATS=1). Without it every
+ * BIGINT_STAT_* hook is empty and snapshot() reads zeros. Counted are calls of the arithmetic entry points with a
+ * histogram of their longer operand, each dispatch of the multiply, division and gcd tiers (recursive steps
+ * included), heap allocations of limb storage and scratch, and calls and cycles of the limb kernels; a kernel's
+ * cycles include the kernels it calls. Every thread counts into its own block without locks, snapshot() sums the
+ * blocks and reset() moves the zero point, so both may run while other threads compute.
+ */
+class bigint_stats
+{
+public:
+    enum op { ADD, SUB, MUL, SQR, DIV, POW_MOD, GCD, PARSE, FORMAT, OP_COUNT };
+    enum path
+    {
+        MUL_BASECASE, MUL_KARATSUBA, MUL_UNBALANCED, MUL_TOOM3, MUL_TOOM4, MUL_NTT,
+        DIV_LIMB, DIV_KNUTH, DIV_BZ, DIV_NEWTON, DIVISOR_LIMB, DIVISOR_KNUTH, DIVISOR_BARRETT,
+        GCD_HGCD, GCD_LEHMER, GCD_DIVIDE, PATH_COUNT
+    };
+    enum kernel { ADD_N, SUB_N, MUL_1, ADDMUL_1, SUBMUL_1, BASECASE_MUL, BASECASE_SQR, KNUTH_CORE, NTT_TRANSFORM, KERNEL_COUNT };
+    // Bucket k of a size histogram counts operands of [2^(k - 1), 2^k) limbs
+    static const u_int32_t SIZE_BUCKETS = 33;
+
+    struct counters
+    {
+        std::array<u_int64_t, OP_COUNT> calls{};
+        std::array<std::array<u_int64_t, SIZE_BUCKETS>, OP_COUNT> sizes{};
+        std::array<u_int64_t, PATH_COUNT> paths{};
+        u_int64_t allocations = 0, allocated_bytes = 0;
+        std::array<u_int64_t, KERNEL_COUNT> kernel_calls{}, kernel_cycles{};
+    };
+
+    static counters snapshot();
+    static void reset();
+    static void dump(std::ostream &out);
+    static void dump(std::ostream &out, const counters &c);
+
+    static void count_op(op o, u_int64_t limbs);
+    static void count_path(path p);
+    static void count_alloc(size_t bytes);
+    static void count_kernel(kernel k, u_int64_t cycles);
+    static u_int64_t cycles();
+
+    // Charges the cycles between construction and destruction to one kernel
+    class kernel_timer
+    {
+    private:
+        kernel k;
+        u_int64_t start;
+
+    public:
+        explicit kernel_timer(kernel which) : k(which), start(bigint_stats::cycles()) {}
+        kernel_timer(const kernel_timer &) = delete;
+        kernel_timer& operator=(const kernel_timer &) = delete;
+        ~kernel_timer() { bigint_stats::count_kernel(k, bigint_stats::cycles() - start); }
+    };
+
+private:
+    static const u_int32_t SLOTS = OP_COUNT * (1 + SIZE_BUCKETS) + PATH_COUNT + 2 + 2 * KERNEL_COUNT;
+    struct block;
+    struct registry;
+
+    static block& local();
+    static registry& shared();
+    static void add(u_int32_t slot, u_int64_t value);
+    static std::array<u_int64_t, SLOTS> totals();
+};
+
+#ifdef BIGINT_STATS
+#define BIGINT_STAT_OP(o, limbs) bigint_stats::count_op(bigint_stats::o, limbs)
+#define BIGINT_STAT_PATH(p) bigint_stats::count_path(bigint_stats::p)
+#define BIGINT_STAT_ALLOC(bytes) bigint_stats::count_alloc(bytes)
+#define BIGINT_STAT_KERNEL(k) bigint_stats::kernel_timer kernel_timer_(bigint_stats::k)
+#else
+#define BIGINT_STAT_OP(o, limbs) ((void) 0)
+#define BIGINT_STAT_PATH(p) ((void) 0)
+#define BIGINT_STAT_ALLOC(bytes) ((void) 0)
+#define BIGINT_STAT_KERNEL(k) ((void) 0)
+#endif
+
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef __BIGINT_THRESHOLDS_H__
+#define __BIGINT_THRESHOLDS_H__
+
+
+/*
+ * Algorithm crossovers in limbs. make tune measures them on the host and rewrites this file,
+ * these are the defaults for base 10^9 limbs.
+ */
+#define BIGINT_KARATSUBA_THRESHOLD 100
+#define BIGINT_TOOM3_THRESHOLD 300
+#define BIGINT_TOOM4_THRESHOLD 900
+#define BIGINT_NTT_THRESHOLD 12000
+#define BIGINT_BZ_THRESHOLD 60
+#define BIGINT_BARRETT_THRESHOLD 100
+#define BIGINT_HGCD_THRESHOLD 400
+#define BIGINT_CONVERSION_THRESHOLD 64
+#define BIGINT_NEWTON_THRESHOLD 300000
+
+
+#endif
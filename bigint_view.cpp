@@ -0,0 +1,61 @@
+#include "bigint_view.h"
+#include "sys/mman.h"
+#include "sys/stat.h"
+#include "fcntl.h"
+#include "unistd.h"
+
+
+/*Constructors, Destructors*/
+bigint_view::bigint_view(const std::string &path) : map(MAP_FAILED), length(0)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return;
+
+    struct stat info;
+    if (!fstat(fd, &info) && (size_t) info.st_size > sizeof(bigint::file_header))
+    {
+        length = info.st_size;
+        map = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (map == MAP_FAILED)
+        return;
+
+    // The limbs start 16 bytes into the page-aligned mapping, which keeps them aligned for in-place use
+    const bigint::file_header &header = *static_cast<const bigint::file_header*>(map);
+    const u_int32_t *limbs = reinterpret_cast<const u_int32_t*>(static_cast<const char*>(map) + sizeof(header));
+    if (std::endian::native != std::endian::little || !bigint::valid_header(header) || header.radix != bigint::file_radix()
+        || length != sizeof(header) + header.limbs * sizeof(u_int32_t) || (header.limbs > 1 && !limbs[header.limbs - 1]))
+    {
+        munmap(map, length);
+        map = MAP_FAILED;
+        return;
+    }
+
+    num.bignum.borrow(limbs, header.limbs);
+    num.neg = header.sign && !(header.limbs == 1 && !limbs[0]);
+}
+
+bigint_view::~bigint_view()
+{
+    if (map != MAP_FAILED)
+        munmap(map, length);
+}
+
+
+/*Public helpers*/
+bool bigint_view::is_open() const
+{
+    return map != MAP_FAILED;
+}
+
+const bigint& bigint_view::value() const
+{
+    return num;
+}
+
+bigint_view::operator const bigint&() const
+{
+    return num;
+}
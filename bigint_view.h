@@ -0,0 +1,33 @@
+#ifndef __BIGINT_VIEW_H__
+#define __BIGINT_VIEW_H__
+
+
+#include "bigint.h"
+
+/*
+ * Read-only bigint over a file written by bigint::save, mapped with mmap. Its limbs are used where they lie in
+ * the mapping, so opening costs neither a copy nor a parse, and value() goes into any const operation of bigint
+ * with pages read in as the operation touches them. Only the header, the file size and the top limb are checked,
+ * the rest is trusted as save wrote it. A file of the other limb radix, or any file on a big-endian host, leaves
+ * the view closed, bigint::load converts those instead.
+ */
+class bigint_view
+{
+private:
+    void *map;
+    size_t length;
+    bigint num;
+
+public:
+    explicit bigint_view(const std::string &path);
+    bigint_view(const bigint_view &) = delete;
+    bigint_view& operator=(const bigint_view &) = delete;
+    ~bigint_view();
+
+    bool is_open() const;
+    const bigint& value() const;
+    operator const bigint&() const;
+};
+
+
+#endif
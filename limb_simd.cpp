@@ -0,0 +1,320 @@
+#include "limb_simd.h"
+#include "bigint.h"
+
+#if defined(__x86_64__) && !defined(BIGINT_NO_SIMD)
+#include "immintrin.h"
+#define LIMB_SIMD_X86
+#endif
+
+
+static constexpr u_int64_t BASE = bigint::limb_base();
+static constexpr bool BINARY = BASE == 1ull << 32;
+
+#ifdef LIMB_SIMD_X86
+// Lane i receives a carry if lane i - 1 generates one or passes on the one it received. Adding the
+// propagate mask to the generated carries ripples them through runs of propagating lanes in one step,
+// just like carries through runs of ones in a binary addition
+static inline u_int32_t carry_lanes(u_int32_t gen, u_int32_t prop, u_int32_t &carry, u_int32_t lanes)
+{
+    u_int32_t in = (gen << 1) | carry, sum = prop + in, received = in | (sum ^ prop ^ in);
+    carry = received >> lanes & 1;
+    return received & ((1u << lanes) - 1);
+}
+
+
+/*AVX2, eight limbs per vector*/
+__attribute__((target("avx2")))
+static inline u_int32_t lane_mask_avx2(__m256i v)
+{
+    return _mm256_movemask_ps(_mm256_castsi256_ps(v));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i lanes_avx2(u_int32_t mask)
+{
+    // All ones in the lanes whose bit is set
+    const __m256i bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    return _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(mask), bits), bits);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i add_avx2(__m256i va, __m256i vb, u_int32_t &carry)
+{
+    // Lane sums first, a lane generates a carry when it reaches BASE and propagates one when it is BASE - 1
+    const __m256i base_m1 = _mm256_set1_epi32((int) (BASE - 1)), sign = _mm256_set1_epi32(INT32_MIN);
+    __m256i sum = _mm256_add_epi32(va, vb), gen;
+    if constexpr (BINARY)
+        gen = _mm256_cmpgt_epi32(_mm256_xor_si256(va, sign), _mm256_xor_si256(sum, sign));
+    else
+    {
+        gen = _mm256_cmpgt_epi32(sum, base_m1);
+        sum = _mm256_sub_epi32(sum, _mm256_and_si256(gen, _mm256_set1_epi32((int) BASE)));
+    }
+
+    u_int32_t received = carry_lanes(lane_mask_avx2(gen), lane_mask_avx2(_mm256_cmpeq_epi32(sum, base_m1)), carry, 8);
+    sum = _mm256_sub_epi32(sum, lanes_avx2(received));
+    if constexpr (!BINARY)
+        sum = _mm256_andnot_si256(_mm256_cmpeq_epi32(sum, _mm256_set1_epi32((int) BASE)), sum);
+    return sum;
+}
+
+__attribute__((target("avx2")))
+static size_t add_n_avx2(u_int32_t *r, const u_int32_t *a, const u_int32_t *b, size_t n, u_int32_t &carry)
+{
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256i va = _mm256_loadu_si256((const __m256i *) (a + i)), vb = _mm256_loadu_si256((const __m256i *) (b + i));
+        _mm256_storeu_si256((__m256i *) (r + i), add_avx2(va, vb, carry));
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t sub_n_avx2(u_int32_t *r, const u_int32_t *a, const u_int32_t *b, size_t n, u_int32_t &borrow)
+{
+    const __m256i zero = _mm256_setzero_si256(), sign = _mm256_set1_epi32(INT32_MIN);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        // A lane generates a borrow when a < b and propagates one when the difference is zero
+        __m256i va = _mm256_loadu_si256((const __m256i *) (a + i)), vb = _mm256_loadu_si256((const __m256i *) (b + i));
+        __m256i diff = _mm256_sub_epi32(va, vb);
+        __m256i gen = _mm256_cmpgt_epi32(_mm256_xor_si256(vb, sign), _mm256_xor_si256(va, sign));
+        if constexpr (!BINARY)
+            diff = _mm256_add_epi32(diff, _mm256_and_si256(gen, _mm256_set1_epi32((int) BASE)));
+
+        u_int32_t received = carry_lanes(lane_mask_avx2(gen), lane_mask_avx2(_mm256_cmpeq_epi32(diff, zero)), borrow, 8);
+        diff = _mm256_add_epi32(diff, lanes_avx2(received));
+        if constexpr (!BINARY)
+            diff = _mm256_blendv_epi8(diff, _mm256_set1_epi32((int) (BASE - 1)), _mm256_cmpeq_epi32(diff, _mm256_set1_epi32(-1)));
+        _mm256_storeu_si256((__m256i *) (r + i), diff);
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static size_t mul_1_avx2(u_int32_t *r, const u_int32_t *a, size_t n, u_int32_t b, u_int32_t &carry)
+{
+    // a[i] * b = high[i] * BASE + low[i], so r = low + (high shifted up one limb) with a single carry chain
+    const __m256i vb = _mm256_set1_epi32(b), odd = _mm256_setr_epi32(7, 0, 1, 2, 3, 4, 5, 6);
+    const __m256d scale = _mm256_set1_pd((double) b / BASE);
+    u_int32_t high = carry, chain = 0;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256i va = _mm256_loadu_si256((const __m256i *) (a + i));
+        __m256i even_prod = _mm256_mul_epu32(va, vb), odd_prod = _mm256_mul_epu32(_mm256_srli_epi64(va, 32), vb);
+        __m256i even_low, odd_low, even_high, odd_high;
+        if constexpr (BINARY)
+        {
+            even_low = even_prod;
+            odd_low = odd_prod;
+            even_high = _mm256_srli_epi64(even_prod, 32);
+            odd_high = _mm256_srli_epi64(odd_prod, 32);
+        }
+        else
+        {
+            // The quotient by BASE estimated in doubles is off by at most one, fixed up in 64-bit lanes
+            const __m256i base = _mm256_set1_epi64x(BASE), base_m1 = _mm256_set1_epi64x(BASE - 1), zero = _mm256_setzero_si256();
+            __m128i q_lo = _mm256_cvttpd_epi32(_mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(va)), scale));
+            __m128i q_hi = _mm256_cvttpd_epi32(_mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(va, 1)), scale));
+            __m256i q = _mm256_set_m128i(q_hi, q_lo);
+            even_high = _mm256_and_si256(q, _mm256_set1_epi64x(0xFFFFFFFF));
+            odd_high = _mm256_srli_epi64(q, 32);
+            even_low = _mm256_sub_epi64(even_prod, _mm256_mul_epu32(even_high, base));
+            odd_low = _mm256_sub_epi64(odd_prod, _mm256_mul_epu32(odd_high, base));
+
+            __m256i under = _mm256_cmpgt_epi64(zero, even_low), over = _mm256_cmpgt_epi64(even_low, base_m1);
+            even_low = _mm256_sub_epi64(_mm256_add_epi64(even_low, _mm256_and_si256(under, base)), _mm256_and_si256(over, base));
+            even_high = _mm256_sub_epi64(_mm256_add_epi64(even_high, under), over);
+            under = _mm256_cmpgt_epi64(zero, odd_low);
+            over = _mm256_cmpgt_epi64(odd_low, base_m1);
+            odd_low = _mm256_sub_epi64(_mm256_add_epi64(odd_low, _mm256_and_si256(under, base)), _mm256_and_si256(over, base));
+            odd_high = _mm256_sub_epi64(_mm256_add_epi64(odd_high, under), over);
+        }
+
+        __m256i low = _mm256_blend_epi32(even_low, _mm256_slli_epi64(odd_low, 32), 0xAA);
+        __m256i highs = _mm256_blend_epi32(even_high, _mm256_slli_epi64(odd_high, 32), 0xAA);
+        __m256i shifted = _mm256_blend_epi32(_mm256_permutevar8x32_epi32(highs, odd), _mm256_set1_epi32(high), 0x01);
+        high = _mm256_extract_epi32(highs, 7);
+        _mm256_storeu_si256((__m256i *) (r + i), add_avx2(low, shifted, chain));
+    }
+
+    carry = high + chain;
+    return i;
+}
+
+
+/*AVX-512, sixteen limbs per vector*/
+// GCC's own intrinsic headers trip -Wmaybe-uninitialized on the deliberately undefined vectors they start from
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+__attribute__((target("avx512f")))
+static inline __m512i add_avx512(__m512i va, __m512i vb, u_int32_t &carry)
+{
+    const __m512i base_m1 = _mm512_set1_epi32((int) (BASE - 1));
+    __m512i sum = _mm512_add_epi32(va, vb);
+    __mmask16 gen;
+    if constexpr (BINARY)
+        gen = _mm512_cmplt_epu32_mask(sum, va);
+    else
+    {
+        gen = _mm512_cmpgt_epu32_mask(sum, base_m1);
+        sum = _mm512_mask_sub_epi32(sum, gen, sum, _mm512_set1_epi32((int) BASE));
+    }
+
+    __mmask16 prop = _mm512_cmpeq_epu32_mask(sum, base_m1);
+    __mmask16 received = carry_lanes(gen, prop, carry, 16);
+    sum = _mm512_mask_add_epi32(sum, received, sum, _mm512_set1_epi32(1));
+    if constexpr (!BINARY)
+        sum = _mm512_mask_mov_epi32(sum, received & prop, _mm512_setzero_si512());
+    return sum;
+}
+
+__attribute__((target("avx512f")))
+static size_t add_n_avx512(u_int32_t *r, const u_int32_t *a, const u_int32_t *b, size_t n, u_int32_t &carry)
+{
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+        _mm512_storeu_si512(r + i, add_avx512(_mm512_loadu_si512(a + i), _mm512_loadu_si512(b + i), carry));
+    return i;
+}
+
+__attribute__((target("avx512f")))
+static size_t sub_n_avx512(u_int32_t *r, const u_int32_t *a, const u_int32_t *b, size_t n, u_int32_t &borrow)
+{
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m512i va = _mm512_loadu_si512(a + i), vb = _mm512_loadu_si512(b + i);
+        __m512i diff = _mm512_sub_epi32(va, vb);
+        __mmask16 gen = _mm512_cmplt_epu32_mask(va, vb);
+        if constexpr (!BINARY)
+            diff = _mm512_mask_add_epi32(diff, gen, diff, _mm512_set1_epi32((int) BASE));
+
+        __mmask16 prop = _mm512_cmpeq_epu32_mask(diff, _mm512_setzero_si512());
+        __mmask16 received = carry_lanes(gen, prop, borrow, 16);
+        diff = _mm512_mask_sub_epi32(diff, received, diff, _mm512_set1_epi32(1));
+        if constexpr (!BINARY)
+            diff = _mm512_mask_mov_epi32(diff, received & prop, _mm512_set1_epi32((int) (BASE - 1)));
+        _mm512_storeu_si512(r + i, diff);
+    }
+    return i;
+}
+
+__attribute__((target("avx512f")))
+static size_t mul_1_avx512(u_int32_t *r, const u_int32_t *a, size_t n, u_int32_t b, u_int32_t &carry)
+{
+    const __m512i vb = _mm512_set1_epi32(b);
+    const __m512d scale = _mm512_set1_pd((double) b / BASE);
+    u_int32_t high = carry, chain = 0;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m512i va = _mm512_loadu_si512(a + i);
+        __m512i even_prod = _mm512_mul_epu32(va, vb), odd_prod = _mm512_mul_epu32(_mm512_srli_epi64(va, 32), vb);
+        __m512i even_low, odd_low, even_high, odd_high;
+        if constexpr (BINARY)
+        {
+            even_low = even_prod;
+            odd_low = odd_prod;
+            even_high = _mm512_srli_epi64(even_prod, 32);
+            odd_high = _mm512_srli_epi64(odd_prod, 32);
+        }
+        else
+        {
+            const __m512i base = _mm512_set1_epi64(BASE), zero = _mm512_setzero_si512(), one = _mm512_set1_epi64(1);
+            __m256i q_lo = _mm512_cvttpd_epu32(_mm512_mul_pd(_mm512_cvtepu32_pd(_mm512_castsi512_si256(va)), scale));
+            __m256i q_hi = _mm512_cvttpd_epu32(_mm512_mul_pd(_mm512_cvtepu32_pd(_mm512_extracti64x4_epi64(va, 1)), scale));
+            __m512i q = _mm512_inserti64x4(_mm512_castsi256_si512(q_lo), q_hi, 1);
+            even_high = _mm512_and_si512(q, _mm512_set1_epi64(0xFFFFFFFF));
+            odd_high = _mm512_srli_epi64(q, 32);
+            even_low = _mm512_sub_epi64(even_prod, _mm512_mul_epu32(even_high, base));
+            odd_low = _mm512_sub_epi64(odd_prod, _mm512_mul_epu32(odd_high, base));
+
+            __mmask8 under = _mm512_cmplt_epi64_mask(even_low, zero), over = _mm512_cmpge_epi64_mask(even_low, base);
+            even_low = _mm512_mask_sub_epi64(_mm512_mask_add_epi64(even_low, under, even_low, base), over, even_low, base);
+            even_high = _mm512_mask_add_epi64(_mm512_mask_sub_epi64(even_high, under, even_high, one), over, even_high, one);
+            under = _mm512_cmplt_epi64_mask(odd_low, zero);
+            over = _mm512_cmpge_epi64_mask(odd_low, base);
+            odd_low = _mm512_mask_sub_epi64(_mm512_mask_add_epi64(odd_low, under, odd_low, base), over, odd_low, base);
+            odd_high = _mm512_mask_add_epi64(_mm512_mask_sub_epi64(odd_high, under, odd_high, one), over, odd_high, one);
+        }
+
+        __m512i low = _mm512_mask_blend_epi32(0xAAAA, even_low, _mm512_slli_epi64(odd_low, 32));
+        __m512i highs = _mm512_mask_blend_epi32(0xAAAA, even_high, _mm512_slli_epi64(odd_high, 32));
+        __m512i shifted = _mm512_alignr_epi32(highs, _mm512_set1_epi32(high), 15);
+        high = _mm_extract_epi32(_mm512_extracti32x4_epi32(highs, 3), 3);
+        _mm512_storeu_si512(r + i, add_avx512(low, shifted, chain));
+    }
+
+    carry = high + chain;
+    return i;
+}
+#pragma GCC diagnostic pop
+#endif
+
+
+/*Dispatch*/
+limb_simd::isa limb_simd::level()
+{
+#ifdef LIMB_SIMD_X86
+    static const isa detected = []
+    {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx512f") ? AVX512 : __builtin_cpu_supports("avx2") ? AVX2 : SCALAR;
+    }();
+    return detected;
+#else
+    return SCALAR;
+#endif
+}
+
+size_t limb_simd::add_n([[maybe_unused]] u_int32_t *r, [[maybe_unused]] const u_int32_t *a, [[maybe_unused]] const u_int32_t *b, [[maybe_unused]] size_t n, [[maybe_unused]] u_int32_t &carry)
+{
+#ifdef LIMB_SIMD_X86
+    switch (limb_simd::level())
+    {
+    case AVX512:
+        return add_n_avx512(r, a, b, n, carry);
+    case AVX2:
+        return add_n_avx2(r, a, b, n, carry);
+    default:
+        break;
+    }
+#endif
+    return 0;
+}
+
+size_t limb_simd::sub_n([[maybe_unused]] u_int32_t *r, [[maybe_unused]] const u_int32_t *a, [[maybe_unused]] const u_int32_t *b, [[maybe_unused]] size_t n, [[maybe_unused]] u_int32_t &borrow)
+{
+#ifdef LIMB_SIMD_X86
+    switch (limb_simd::level())
+    {
+    case AVX512:
+        return sub_n_avx512(r, a, b, n, borrow);
+    case AVX2:
+        return sub_n_avx2(r, a, b, n, borrow);
+    default:
+        break;
+    }
+#endif
+    return 0;
+}
+
+size_t limb_simd::mul_1([[maybe_unused]] u_int32_t *r, [[maybe_unused]] const u_int32_t *a, [[maybe_unused]] size_t n, [[maybe_unused]] u_int32_t b, [[maybe_unused]] u_int32_t &carry)
+{
+#ifdef LIMB_SIMD_X86
+    switch (limb_simd::level())
+    {
+    case AVX512:
+        return mul_1_avx512(r, a, n, b, carry);
+    case AVX2:
+        return mul_1_avx2(r, a, n, b, carry);
+    default:
+        break;
+    }
+#endif
+    return 0;
+}
@@ -0,0 +1,27 @@
+#ifndef __LIMB_SIMD_H__
+#define __LIMB_SIMD_H__
+
+
+#include "sys/types.h"
+#include "cstddef"
+
+/*
+ * Vectorized blocks of the add_n, sub_n and mul_1 span kernels. The instruction set (AVX-512, AVX2 or
+ * none) is picked once from what the CPU supports. Each call handles the longest prefix of whole vectors,
+ * threads the running carry through `carry` and returns how many limbs it wrote, the scalar loop does
+ * the rest. Building with -DBIGINT_NO_SIMD turns every call into a no-op.
+ */
+class limb_simd
+{
+public:
+    static size_t add_n(u_int32_t *r, const u_int32_t *a, const u_int32_t *b, size_t n, u_int32_t &carry);
+    static size_t sub_n(u_int32_t *r, const u_int32_t *a, const u_int32_t *b, size_t n, u_int32_t &borrow);
+    static size_t mul_1(u_int32_t *r, const u_int32_t *a, size_t n, u_int32_t b, u_int32_t &carry);
+
+private:
+    enum isa { SCALAR, AVX2, AVX512 };
+    static isa level();
+};
+
+
+#endif
@@ -0,0 +1,179 @@
+#ifndef __LIMB_VECTOR_H__
+#define __LIMB_VECTOR_H__
+
+
+#include "sys/types.h"
+#include "cstring"
+#include "iterator"
+#include "algorithm"
+#include "bigint_stats.h"
+
+/*
+ * Contiguous limb storage that keeps up to INLINE_LIMBS limbs inside the object and only spills to
+ * the heap beyond that, so short bigints and their temporaries never allocate. It mirrors the subset
+ * of std::vector that bigint uses; a moved-from limb_vector is empty. A borrowed span (capacity zero)
+ * is read where it lies and copied out by the first call that needs room, it must not be written in place.
+ */
+class limb_vector
+{
+public:
+    static const u_int32_t INLINE_LIMBS = 4;
+
+    typedef u_int32_t value_type;
+    typedef u_int32_t* iterator;
+    typedef const u_int32_t* const_iterator;
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    limb_vector() : ptr(local), len(0), cap(INLINE_LIMBS) {}
+    limb_vector(size_t count, u_int32_t value) : limb_vector() { assign(count, value); }
+    limb_vector(const u_int32_t *first, const u_int32_t *last) : limb_vector() { assign(first, last); }
+    limb_vector(const limb_vector &other) : limb_vector() { assign(other.begin(), other.end()); }
+    limb_vector(limb_vector &&other) noexcept : limb_vector() { steal(other); }
+    ~limb_vector() { release(); }
+
+    limb_vector& operator=(const limb_vector &other)
+    {
+        if (this != &other)
+            assign(other.begin(), other.end());
+        return *this;
+    }
+
+    limb_vector& operator=(limb_vector &&other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            ptr = local;
+            cap = INLINE_LIMBS;
+            steal(other);
+        }
+        return *this;
+    }
+
+    size_t size() const { return len; }
+    size_t capacity() const { return cap; }
+    bool empty() const { return !len; }
+
+    u_int32_t* data() { return ptr; }
+    const u_int32_t* data() const { return ptr; }
+    u_int32_t& operator[](size_t idx) { return ptr[idx]; }
+    const u_int32_t& operator[](size_t idx) const { return ptr[idx]; }
+    u_int32_t& back() { return ptr[len - 1]; }
+    const u_int32_t& back() const { return ptr[len - 1]; }
+
+    iterator begin() { return ptr; }
+    iterator end() { return ptr + len; }
+    const_iterator begin() const { return ptr; }
+    const_iterator end() const { return ptr + len; }
+    reverse_iterator rbegin() { return reverse_iterator(end()); }
+    reverse_iterator rend() { return reverse_iterator(begin()); }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+    const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+    void reserve(size_t count)
+    {
+        if (count > cap)
+            grow(count);
+    }
+
+    void borrow(const u_int32_t *first, size_t count)
+    {
+        release();
+        ptr = const_cast<u_int32_t*>(first);
+        len = count;
+        cap = 0;
+    }
+
+    void clear() { len = 0; }
+    void pop_back() { len--; }
+
+    void emplace_back(u_int32_t value)
+    {
+        if (len >= cap)
+            grow(std::max<size_t>(2 * (size_t) cap, len + 1));
+        ptr[len++] = value;
+    }
+
+    void resize(size_t count, u_int32_t value = 0)
+    {
+        if (count > len)
+        {
+            reserve(count);
+            std::fill(ptr + len, ptr + count, value);
+        }
+        len = count;
+    }
+
+    void assign(size_t count, u_int32_t value)
+    {
+        len = 0;
+        resize(count, value);
+    }
+
+    void assign(const u_int32_t *first, const u_int32_t *last)
+    {
+        len = 0;
+        reserve(last - first);
+        memmove(ptr, first, (last - first) * sizeof(u_int32_t));
+        len = last - first;
+    }
+
+    iterator insert(const_iterator pos, size_t count, u_int32_t value)
+    {
+        size_t idx = pos - ptr;
+        reserve(len + count);
+        memmove(ptr + idx + count, ptr + idx, (len - idx) * sizeof(u_int32_t));
+        std::fill(ptr + idx, ptr + idx + count, value);
+        len += count;
+        return ptr + idx;
+    }
+
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        size_t idx = first - ptr, count = last - first;
+        memmove(ptr + idx, ptr + idx + count, (len - idx - count) * sizeof(u_int32_t));
+        len -= count;
+        return ptr + idx;
+    }
+
+private:
+    u_int32_t *ptr;
+    u_int32_t len, cap;
+    u_int32_t local[INLINE_LIMBS];
+
+    void grow(size_t count)
+    {
+        u_int32_t *mem = new u_int32_t[count];
+        BIGINT_STAT_ALLOC(count * sizeof(u_int32_t));
+        memcpy(mem, ptr, len * sizeof(u_int32_t));
+        release();
+        ptr = mem;
+        cap = count;
+    }
+
+    void release()
+    {
+        if (ptr != local && cap)
+            delete[] ptr;
+    }
+
+    void steal(limb_vector &other)
+    {
+        if (other.ptr == other.local)
+            memcpy(local, other.local, other.len * sizeof(u_int32_t));
+        else
+        {
+            ptr = other.ptr;
+            cap = other.cap;
+            other.ptr = other.local;
+            other.cap = INLINE_LIMBS;
+        }
+
+        len = other.len;
+        other.len = 0;
+    }
+};
+
+
+#endif
@@ -1,7 +1,13 @@
 #include "bigint.h"
+#include "bigint_divisor.h"
+#include "bigint_view.h"
+#include "sstream"
+#include "fcntl.h"
+#include "unistd.h"
 #include "random"
 #include "gmpxx.h"
 #include "chrono"
+#include "atomic"
 
 
 // Macros for benching performance against the GMP Library
@@ -10,6 +16,25 @@
 #define RACE(loc1, loc2, var1, var2) { auto start = std::chrono::high_resolution_clock::now(); loc1; auto end = std::chrono::high_resolution_clock::now(); std::chrono::duration<double> duration1 = end - start; start = std::chrono::high_resolution_clock::now(); loc2; end = std::chrono::high_resolution_clock::now(); std::chrono::duration<double> duration2 = end - start; if (duration1 < duration2) var1++; else var2++; }
 
 
+#ifdef ALLOC_COUNT
+// Counts every heap allocation so temporary-heavy paths can be checked for allocation-freedom
+static std::atomic<u_int64_t> allocations(0);
+
+void* operator new(size_t size)
+{
+    allocations++;
+    if (void *mem = malloc(size ? size : 1))
+        return mem;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *mem) noexcept { free(mem); }
+void operator delete(void *mem, size_t) noexcept { free(mem); }
+
+#define ALLOCS(loc, var) { u_int64_t before = allocations; loc; var += allocations - before; }
+#endif
+
+
 static std::random_device rd;
 static std::mt19937 gen(rd());
 static std::uniform_int_distribution<> distr(0,9);
@@ -40,12 +65,15 @@ std::string generate(int num_digs)
 
 int main(int argc, char const *argv[])
 {
-    assert(argc == 5);
+    assert(argc == 5 || argc == 6);
     int l1 = atoi(argv[1]);
     int l2 = atoi(argv[2]);
     int iter = atoi(argv[4]);
+    if (argc == 6)
+        bigint::set_threads(atoi(argv[5]));
 
     int dark = 0, gmp = 0;
+    [[maybe_unused]] u_int64_t dark_allocs = 0;
     for (int i = 0; i < iter; i++)
     {
         std::string n1 = generate(l1), n2 = generate(l2);
@@ -61,6 +89,9 @@ int main(int argc, char const *argv[])
         switch (argv[3][0])
         {
         case '+':
+            #ifdef ALLOC_COUNT
+            ALLOCS(my_res = num1 + num2, dark_allocs)
+            #endif
             #ifdef TIMER
             TIME(my_res = num1 + num2, "Dark")
             TIME(res = mpz1 + mpz2, "GMP")
@@ -76,6 +107,9 @@ int main(int argc, char const *argv[])
             break;
         
         case '-':
+            #ifdef ALLOC_COUNT
+            ALLOCS(my_res = num1 - num2, dark_allocs)
+            #endif
             #ifdef TIMER
             TIME(my_res = num1 - num2, "Dark")
             TIME(res = mpz1 - mpz2, "GMP")
@@ -91,6 +125,9 @@ int main(int argc, char const *argv[])
             break;
 
         case 'x':
+            #ifdef ALLOC_COUNT
+            ALLOCS(my_res = num1 * num2, dark_allocs)
+            #endif
             #ifdef TIMER
             TIME(my_res = num1 * num2, "Dark")
             TIME(res = mpz1 * mpz2, "GMP")
@@ -105,7 +142,28 @@ int main(int argc, char const *argv[])
             assert(my_res == convres);
             break;
         
+        case 's':
+            #ifdef ALLOC_COUNT
+            ALLOCS(my_res = num1.square(), dark_allocs)
+            #endif
+            #ifdef TIMER
+            TIME(my_res = num1.square(), "Dark")
+            TIME(res = mpz1 * mpz1, "GMP")
+            #endif
+            #ifndef TIMER
+            RACE(my_res = num1.square(), res = mpz1 * mpz1, dark, gmp)
+            #endif
+            convres = res.get_str();
+            #ifdef PRINT
+            std::cout << convres << "\n" << my_res << "\n" << std::endl;
+            #endif
+            assert(my_res == convres);
+            break;
+
         case '/':
+            #ifdef ALLOC_COUNT
+            ALLOCS(my_res = num1 / num2, dark_allocs)
+            #endif
             #ifdef TIMER
             TIME(my_res = num1 / num2, "Dark")
             TIME(res = mpz1 / mpz2, "GMP")
@@ -121,6 +179,9 @@ int main(int argc, char const *argv[])
             break;
 
         case '%':
+            #ifdef ALLOC_COUNT
+            ALLOCS(my_res = num1 % num2, dark_allocs)
+            #endif
             #ifdef TIMER
             TIME(my_res = num1 % num2, "Dark")
             TIME(res = mpz1 % mpz2, "GMP")
@@ -135,11 +196,525 @@ int main(int argc, char const *argv[])
             assert(my_res == convres);
             break;
         
+        case 'd':
+        {
+            // Division through a prepared divisor, its setup is left out of the race
+            bigint_divisor divisor(num2);
+            #ifdef ALLOC_COUNT
+            ALLOCS(my_res = divisor.div(num1), dark_allocs)
+            #endif
+            #ifdef TIMER
+            TIME(my_res = divisor.div(num1), "Dark")
+            TIME(res = mpz1 / mpz2, "GMP")
+            #endif
+            #ifndef TIMER
+            RACE(my_res = divisor.div(num1), res = mpz1 / mpz2, dark, gmp)
+            #endif
+            convres = res.get_str();
+            #ifdef PRINT
+            std::cout << convres << "\n" << my_res << "\n" << std::endl;
+            #endif
+            assert(my_res == convres);
+            assert(divisor.mod(num1) == bigint(mpz_class(mpz1 % mpz2).get_str()));
+            break;
+        }
+
+        case '^':
+            // num1 to the power of the second size argument
+            #ifdef ALLOC_COUNT
+            ALLOCS(my_res = bigint::pow(num1, l2), dark_allocs)
+            #endif
+            #ifdef TIMER
+            TIME(my_res = bigint::pow(num1, l2), "Dark")
+            TIME(mpz_pow_ui(res.get_mpz_t(), mpz1.get_mpz_t(), l2), "GMP")
+            #endif
+            #ifndef TIMER
+            RACE(my_res = bigint::pow(num1, l2), mpz_pow_ui(res.get_mpz_t(), mpz1.get_mpz_t(), l2), dark, gmp)
+            #endif
+            convres = res.get_str();
+            #ifdef PRINT
+            std::cout << convres << "\n" << my_res << "\n" << std::endl;
+            #endif
+            assert(my_res == convres);
+            break;
+
+        case '!':
+            // The first size argument is n itself, n!
+            #ifdef ALLOC_COUNT
+            ALLOCS(my_res = bigint::factorial(l1), dark_allocs)
+            #endif
+            #ifdef TIMER
+            TIME(my_res = bigint::factorial(l1), "Dark")
+            TIME(mpz_fac_ui(res.get_mpz_t(), l1), "GMP")
+            #endif
+            #ifndef TIMER
+            RACE(my_res = bigint::factorial(l1), mpz_fac_ui(res.get_mpz_t(), l1), dark, gmp)
+            #endif
+            convres = res.get_str();
+            #ifdef PRINT
+            std::cout << convres << "\n" << my_res << "\n" << std::endl;
+            #endif
+            assert(my_res == convres);
+            break;
+
+        case 'b':
+            // Both size arguments are the operands themselves, l1 choose l2
+            #ifdef ALLOC_COUNT
+            ALLOCS(my_res = bigint::binomial(l1, l2), dark_allocs)
+            #endif
+            #ifdef TIMER
+            TIME(my_res = bigint::binomial(l1, l2), "Dark")
+            TIME(mpz_bin_uiui(res.get_mpz_t(), l1, l2), "GMP")
+            #endif
+            #ifndef TIMER
+            RACE(my_res = bigint::binomial(l1, l2), mpz_bin_uiui(res.get_mpz_t(), l1, l2), dark, gmp)
+            #endif
+            convres = res.get_str();
+            #ifdef PRINT
+            std::cout << convres << "\n" << my_res << "\n" << std::endl;
+            #endif
+            assert(my_res == convres);
+            break;
+
+        case 'q':
+        {
+            // Square root of |num1|
+            bigint mag(n1[0] == '-' ? n1.substr(1) : n1);
+            mpz_class mpz_mag(abs(mpz1));
+            #ifdef ALLOC_COUNT
+            ALLOCS(my_res = bigint::isqrt(mag), dark_allocs)
+            #endif
+            #ifdef TIMER
+            TIME(my_res = bigint::isqrt(mag), "Dark")
+            TIME(mpz_sqrt(res.get_mpz_t(), mpz_mag.get_mpz_t()), "GMP")
+            #endif
+            #ifndef TIMER
+            RACE(my_res = bigint::isqrt(mag), mpz_sqrt(res.get_mpz_t(), mpz_mag.get_mpz_t()), dark, gmp)
+            #endif
+            convres = res.get_str();
+            #ifdef PRINT
+            std::cout << convres << "\n" << my_res << "\n" << std::endl;
+            #endif
+            assert(my_res == convres);
+
+            // The root is BASE^2 - 1, the largest one the two limb estimate covers
+            bigint base(bigint::limb_base()), edge(bigint::pow(base, 2) - bigint(1));
+            assert(bigint::isqrt(bigint::pow(base, 4) - bigint(1)) == edge);
+            break;
+        }
+
+        case 'r':
+        {
+            // The second size argument is the root's degree, even roots are taken of |num1|
+            bigint radicand(l2 % 2 || n1[0] != '-' ? n1 : n1.substr(1));
+            mpz_class mpz_radicand(l2 % 2 ? mpz1 : abs(mpz1));
+            #ifdef ALLOC_COUNT
+            ALLOCS(my_res = bigint::iroot(radicand, l2), dark_allocs)
+            #endif
+            #ifdef TIMER
+            TIME(my_res = bigint::iroot(radicand, l2), "Dark")
+            TIME(mpz_root(res.get_mpz_t(), mpz_radicand.get_mpz_t(), l2), "GMP")
+            #endif
+            #ifndef TIMER
+            RACE(my_res = bigint::iroot(radicand, l2), mpz_root(res.get_mpz_t(), mpz_radicand.get_mpz_t(), l2), dark, gmp)
+            #endif
+            convres = res.get_str();
+            #ifdef PRINT
+            std::cout << convres << "\n" << my_res << "\n" << std::endl;
+            #endif
+            assert(my_res == convres);
+
+            bigint base(bigint::limb_base()), edge(bigint::pow(base, 2) - bigint(1));
+            assert(bigint::iroot(bigint::pow(base, 6) - bigint(1), 3) == edge);
+            break;
+        }
+
+        case 'p':
+        {
+            // num1 to the power of the second size argument, then both perfect power tests on it and on its successor
+            bigint power(bigint::pow(num1, l2));
+            mpz_class mpz_power;
+            mpz_pow_ui(mpz_power.get_mpz_t(), mpz1.get_mpz_t(), l2);
+            for (int step = 0; step < 2; step++, power += bigint(1), mpz_power += 1)
+            {
+                bool my_pp = false, gmp_pp = false;
+                #ifdef TIMER
+                TIME(my_pp = bigint::is_perfect_power(power), "Dark")
+                TIME(gmp_pp = mpz_perfect_power_p(mpz_power.get_mpz_t()), "GMP")
+                #endif
+                #ifndef TIMER
+                RACE(my_pp = bigint::is_perfect_power(power), gmp_pp = mpz_perfect_power_p(mpz_power.get_mpz_t()), dark, gmp)
+                #endif
+                assert(my_pp == gmp_pp);
+                assert(bigint::is_perfect_square(power) == (bool) mpz_perfect_square_p(mpz_power.get_mpz_t()));
+            }
+            break;
+        }
+
+        case 'g':
+        {
+            // gcd of the pair, then of both times num2 + 1 so the result is large too
+            for (int step = 0; step < 2; step++)
+            {
+                #ifdef ALLOC_COUNT
+                ALLOCS(my_res = bigint::gcd(num1, num2), dark_allocs)
+                #endif
+                #ifdef TIMER
+                TIME(my_res = bigint::gcd(num1, num2), "Dark")
+                TIME(mpz_gcd(res.get_mpz_t(), mpz1.get_mpz_t(), mpz2.get_mpz_t()), "GMP")
+                #endif
+                #ifndef TIMER
+                RACE(my_res = bigint::gcd(num1, num2), mpz_gcd(res.get_mpz_t(), mpz1.get_mpz_t(), mpz2.get_mpz_t()), dark, gmp)
+                #endif
+                convres = res.get_str();
+                #ifdef PRINT
+                std::cout << convres << "\n" << my_res << "\n" << std::endl;
+                #endif
+                assert(my_res == convres);
+
+                bigint common(num2 + bigint(1));
+                num1 *= common;
+                num2 *= common;
+                mpz_class mpz_common(mpz2 + 1);
+                mpz1 *= mpz_common;
+                mpz2 *= mpz_common;
+            }
+            break;
+        }
+
+        case 'e':
+        {
+            // Extended gcd, the cofactors must satisfy the identity with |s| <= |num2| / 2g
+            bigint s, t;
+            mpz_class mpz_cs, mpz_ct;
+            #ifdef ALLOC_COUNT
+            ALLOCS(my_res = bigint::xgcd(num1, num2, s, t), dark_allocs)
+            #endif
+            #ifdef TIMER
+            TIME(my_res = bigint::xgcd(num1, num2, s, t), "Dark")
+            TIME(mpz_gcdext(res.get_mpz_t(), mpz_cs.get_mpz_t(), mpz_ct.get_mpz_t(), mpz1.get_mpz_t(), mpz2.get_mpz_t()), "GMP")
+            #endif
+            #ifndef TIMER
+            RACE(my_res = bigint::xgcd(num1, num2, s, t), mpz_gcdext(res.get_mpz_t(), mpz_cs.get_mpz_t(), mpz_ct.get_mpz_t(), mpz1.get_mpz_t(), mpz2.get_mpz_t()), dark, gmp)
+            #endif
+            convres = res.get_str();
+            #ifdef PRINT
+            std::cout << convres << "\n" << my_res << "\n" << s << "\n" << t << "\n" << std::endl;
+            #endif
+            assert(my_res == convres);
+            assert(s * num1 + t * num2 == my_res);
+            mpz_class mpz_bound(abs(mpz2) / (2 * res));
+            assert(abs(mpz_class(s.to_string())) <= mpz_bound + 1);
+            break;
+        }
+
+        case 'i':
+        {
+            // Inverse of num1 modulo |num2|, zero when there is none
+            bigint mod(n2[0] == '-' ? n2.substr(1) : n2);
+            mpz_class mpz_mod(abs(mpz2));
+            bool has_inverse = true;
+            #ifdef ALLOC_COUNT
+            ALLOCS(my_res = bigint::mod_inverse(num1, mod), dark_allocs)
+            #endif
+            #ifdef TIMER
+            TIME(my_res = bigint::mod_inverse(num1, mod), "Dark")
+            TIME(has_inverse = mpz_invert(res.get_mpz_t(), mpz1.get_mpz_t(), mpz_mod.get_mpz_t()), "GMP")
+            #endif
+            #ifndef TIMER
+            RACE(my_res = bigint::mod_inverse(num1, mod), has_inverse = mpz_invert(res.get_mpz_t(), mpz1.get_mpz_t(), mpz_mod.get_mpz_t()), dark, gmp)
+            #endif
+            convres = has_inverse ? res.get_str() : "0";
+            #ifdef PRINT
+            std::cout << convres << "\n" << my_res << "\n" << std::endl;
+            #endif
+            assert(my_res == convres);
+            break;
+        }
+
+        case 'm':
+        {
+            // num2^|num1| modulo |num2| with its last digit set to 7 (Montgomery), 4 (Barrett) and 5 (Barrett for
+            // decimal limbs), pow_mod_ct on the moduli coprime to the limb base. Large num2 leaves the 2^73 column bound
+            bigint exp(n1[0] == '-' ? n1.substr(1) : n1);
+            mpz_class mpz_exp(abs(mpz1));
+            for (char last : {'7', '4', '5'})
+            {
+                std::string m = n2[0] == '-' ? n2.substr(1) : n2;
+                m.back() = last;
+                bigint mod(m);
+                mpz_class mpz_mod(m);
+                #ifdef ALLOC_COUNT
+                ALLOCS(my_res = bigint::pow_mod(num2, exp, mod), dark_allocs)
+                #endif
+                #ifdef TIMER
+                TIME(my_res = bigint::pow_mod(num2, exp, mod), "Dark")
+                TIME(mpz_powm(res.get_mpz_t(), mpz2.get_mpz_t(), mpz_exp.get_mpz_t(), mpz_mod.get_mpz_t()), "GMP")
+                #endif
+                #ifndef TIMER
+                RACE(my_res = bigint::pow_mod(num2, exp, mod), mpz_powm(res.get_mpz_t(), mpz2.get_mpz_t(), mpz_exp.get_mpz_t(), mpz_mod.get_mpz_t()), dark, gmp)
+                #endif
+                convres = res.get_str();
+                #ifdef PRINT
+                std::cout << convres << "\n" << my_res << "\n" << std::endl;
+                #endif
+                assert(my_res == convres);
+                if (last == '7' || (last == '5' && bigint::limb_base() == 1ull << 32))
+                    assert(bigint::pow_mod_ct(num2, exp, mod) == convres);
+            }
+            break;
+        }
+
+        case 'B':
+        {
+            // Batches of 256 pairs: products raced against the same mpz_class loop, then every batch call
+            // checked against the scalar operators
+            const int count = 256;
+            std::vector<bigint> xs, ys, out(count);
+            std::vector<mpz_class> mpz_xs, mpz_ys, mpz_out(count);
+            for (int k = 0; k < count; k++)
+            {
+                std::string s1 = generate(l1), s2 = generate(l2);
+                xs.emplace_back(s1);
+                ys.emplace_back(s2);
+                mpz_xs.emplace_back(s1);
+                mpz_ys.emplace_back(s2);
+            }
+
+            #ifdef ALLOC_COUNT
+            ALLOCS(bigint::batch_mul(xs, ys, out), dark_allocs)
+            #endif
+            #ifdef TIMER
+            TIME(bigint::batch_mul(xs, ys, out), "Dark")
+            TIME(for (int k = 0; k < count; k++) mpz_out[k] = mpz_xs[k] * mpz_ys[k], "GMP")
+            #endif
+            #ifndef TIMER
+            RACE(bigint::batch_mul(xs, ys, out), for (int k = 0; k < count; k++) mpz_out[k] = mpz_xs[k] * mpz_ys[k], dark, gmp)
+            #endif
+            for (int k = 0; k < count; k++)
+                assert(out[k] == bigint(mpz_out[k].get_str()) && out[k] == xs[k] * ys[k]);
+
+            bigint::batch_add(xs, ys, out);
+            for (int k = 0; k < count; k++)
+                assert(out[k] == xs[k] + ys[k]);
+
+            bigint::batch_mod(xs, ys, out);
+            for (int k = 0; k < count; k++)
+                assert(out[k] == xs[k] % ys[k]);
+
+            bigint::batch_mod(xs, ys[0], out);
+            for (int k = 0; k < count; k++)
+                assert(out[k] == xs[k] % ys[0]);
+
+            bigint total;
+            mpz_class mpz_prod(1);
+            for (int k = 0; k < count; k++)
+            {
+                total += xs[k];
+                mpz_prod *= mpz_ys[k];
+            }
+            assert(bigint::sum(xs) == total && bigint::product(ys) == bigint(mpz_prod.get_str()));
+            break;
+        }
+
+        case 'w':
+        {
+            // Binary save and load through a file raced against mpz_out_raw and mpz_inp_raw, then the same file
+            // through a mapped view, and hand-written files of both limb radixes through load
+            const char *path = "/tmp/bigint_save.bin";
+            auto dark_io = [&]
+            {
+                {
+                    std::ofstream out(path, std::ios::binary);
+                    num1.save(out);
+                }
+                std::ifstream in(path, std::ios::binary);
+                return bigint::load(in);
+            };
+            auto gmp_io = [&]
+            {
+                FILE *file = fopen(path, "wb");
+                mpz_out_raw(file, mpz1.get_mpz_t());
+                fclose(file);
+                file = fopen(path, "rb");
+                mpz_inp_raw(res.get_mpz_t(), file);
+                fclose(file);
+            };
+            #ifdef ALLOC_COUNT
+            ALLOCS(my_res = dark_io(), dark_allocs)
+            #endif
+            #ifdef TIMER
+            TIME(my_res = dark_io(), "Dark")
+            TIME(gmp_io(), "GMP")
+            #endif
+            #ifndef TIMER
+            RACE(my_res = dark_io(), gmp_io(), dark, gmp)
+            #endif
+            assert(my_res == num1 && res == mpz1);
+
+            {
+                std::ofstream out(path, std::ios::binary);
+                num1.save(out);
+            }
+            {
+                bigint_view view(path);
+                assert(view.is_open() && view.value() == num1);
+                assert(view.value() * num2 == num1 * num2 && bigint::gcd(view, num2) == bigint::gcd(num1, num2));
+            }
+
+            // Base 2^32 words from mpz_export and base 10^9 groups of the decimal digits
+            std::string digits(n1[0] == '-' ? n1.substr(1) : n1);
+            std::vector<u_int32_t> words(mpz_sizeinbase(mpz1.get_mpz_t(), 2) / 32 + 1), groups;
+            size_t used = 0;
+            mpz_export(words.data(), &used, -1, 4, 0, 0, mpz1.get_mpz_t());
+            words.resize(used);
+            for (size_t end = digits.size(); end > 0; end -= std::min<size_t>(end, 9))
+                groups.emplace_back(std::stoul(digits.substr(end - std::min<size_t>(end, 9), std::min<size_t>(end, 9))));
+
+            for (auto [radix, limbs] : {std::pair<u_int8_t, std::vector<u_int32_t>*>(1, &words), {0, &groups}})
+            {
+                std::stringstream file;
+                u_int16_t version = 1;
+                u_int8_t sign = n1[0] == '-';
+                u_int64_t len = limbs->size();
+                file.write("BGNT", 4);
+                file.write(reinterpret_cast<const char*>(&version), 2);
+                file.write(reinterpret_cast<const char*>(&radix), 1);
+                file.write(reinterpret_cast<const char*>(&sign), 1);
+                file.write(reinterpret_cast<const char*>(&len), 8);
+                file.write(reinterpret_cast<const char*>(limbs->data()), 4 * len);
+                assert(bigint::load(file) == num1 && file);
+            }
+
+            std::stringstream truncated(std::string("BGNT", 4));
+            bigint::load(truncated);
+            assert(truncated.fail());
+
+            // A header claiming 2^32 - 1 limbs ahead of two must fail without allocating for the claim
+            std::stringstream oversized;
+            u_int64_t claim = UINT32_MAX;
+            oversized.write("BGNT\1\0\0\0", 8);
+            oversized.write(reinterpret_cast<const char*>(&claim), 8);
+            oversized.write("\1\0\0\0\1\0\0\0", 8);
+            bigint::load(oversized);
+            assert(oversized.fail());
+            break;
+        }
+
+        case 't':
+        {
+            // Decimal text out and back in through a string stream raced against mpz_class, then through a file
+            // descriptor, then a stream holding more than the number
+            std::stringstream text, mpz_text;
+            auto dark_io = [&]
+            {
+                text << num1;
+                text >> my_res;
+            };
+            auto gmp_io = [&]
+            {
+                mpz_text << mpz1;
+                mpz_text >> res;
+            };
+            #ifdef ALLOC_COUNT
+            ALLOCS(dark_io(), dark_allocs)
+            #endif
+            #ifdef TIMER
+            TIME(dark_io(), "Dark")
+            TIME(gmp_io(), "GMP")
+            #endif
+            #ifndef TIMER
+            RACE(dark_io(), gmp_io(), dark, gmp)
+            #endif
+            assert(my_res == num1 && text.eof() && !text.fail() && res == mpz1);
+
+            const char *path = "/tmp/bigint_text.txt";
+            int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            assert(fd >= 0 && num1.write(fd));
+            close(fd);
+            fd = open(path, O_RDONLY);
+            bigint from_fd;
+            assert(fd >= 0 && bigint::read(fd, from_fd) && from_fd == num1);
+            close(fd);
+
+            std::string padded(n1[0] == '-' ? "-000" + n1.substr(1) : "000" + n1);
+            std::stringstream mixed("  " + n2 + "x " + padded + "\n-");
+            bigint first, second, third;
+            mixed >> first;
+            assert(first == num2 && mixed.get() == 'x');
+            mixed >> second;
+            assert(second == num1 && !(mixed >> third));
+            break;
+        }
+
+        case 'c':
+        {
+            // Machine integer operands: a one-limb multiply and remainder raced against mpz_class, then every operator
+            // checked against the bigint one on both numbers, on values equal or next to the operand, and on zero
+            std::uniform_int_distribution<u_int64_t> any;
+            unsigned long small = any(gen) % 999'999'000 + 2;
+            #ifdef ALLOC_COUNT
+            ALLOCS(my_res = num1 * small + num1 % small, dark_allocs)
+            #endif
+            #ifdef TIMER
+            TIME(my_res = num1 * small + num1 % small, "Dark")
+            TIME(res = mpz1 * small + mpz1 % small, "GMP")
+            #endif
+            #ifndef TIMER
+            RACE(my_res = num1 * small + num1 % small, res = mpz1 * small + mpz1 % small, dark, gmp)
+            #endif
+            convres = res.get_str();
+            assert(my_res == convres);
+
+            auto check = [](const bigint &a, auto v)
+            {
+                bigint ref(std::to_string(v)), x(a);
+                assert(a + v == a + ref && a - v == a - ref && a * v == a * ref);
+                assert((a == v) == (a == ref) && (a != v) == (a != ref) && (a < v) == (a < ref) && (a > v) == (a > ref));
+                assert((a <= v) == (a <= ref) && (a >= v) == (a >= ref));
+                x += v;
+                x -= v;
+                x *= v;
+                assert(x == a * ref);
+                if (v)
+                {
+                    assert(a / v == a / ref && a % v == a % ref);
+                    x = a;
+                    x /= v;
+                    assert(x == a / ref);
+                    x = a;
+                    x %= v;
+                    assert(x == a % ref);
+                }
+            };
+            auto check_all = [&](auto v)
+            {
+                bigint same(std::to_string(v));
+                for (const bigint &a : {num1, num2, bigint(0) - num1, bigint(0), same, same + bigint(1), same - bigint(1), bigint(0) - same})
+                    check(a, v);
+            };
+
+            for (int64_t v : {(int64_t) 0, (int64_t) 1, (int64_t) -1, (int64_t) 7, (int64_t) -7, (int64_t) 999'999'999, (int64_t) 1'000'000'000,
+                              (int64_t) -1'000'000'000, (int64_t) UINT32_MAX, (int64_t) UINT32_MAX + 1, INT64_MAX, INT64_MIN, (int64_t) any(gen)})
+                check_all(v);
+            for (u_int64_t v : {(u_int64_t) 0, (u_int64_t) 1, (u_int64_t) small, (u_int64_t) INT64_MAX + 1, UINT64_MAX, any(gen)})
+                check_all(v);
+            check_all(-3);
+            check_all(10u);
+            break;
+        }
+
         default:
             std::cout << "NOT IMPLEMENTED!" << std::endl;
         }
     }
 
     std::cout << "Final Score\nDark: " << dark << "\nGMP: " << gmp << std::endl;
+    #ifdef ALLOC_COUNT
+    std::cout << "Dark allocations per op: " << (double) dark_allocs / iter << std::endl;
+    #endif
+    #ifdef BIGINT_STATS
+    bigint_stats::dump(std::cout);
+    #endif
     return 0;
 }
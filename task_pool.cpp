@@ -0,0 +1,126 @@
+#include "task_pool.h"
+
+
+thread_local const task_pool *task_pool::owner = nullptr;
+thread_local u_int32_t task_pool::self = 0;
+
+
+/*Constructors and Destructors*/
+task_pool::task_pool(u_int32_t threads) : pending(0), stop(false)
+{
+    threads = std::max(threads, 1u);
+    for (u_int32_t idx = 0; idx < threads; idx++)
+        queues.emplace_back(std::make_unique<worker_queue>());
+
+    // The forking thread does its share of the work, so one fewer worker is spawned
+    for (u_int32_t idx = 1; idx < threads; idx++)
+        workers.emplace_back(&task_pool::worker_loop, this, idx);
+}
+
+task_pool::~task_pool()
+{
+    {
+        std::lock_guard<std::mutex> guard(idle_lock);
+        stop = true;
+    }
+    idle.notify_all();
+
+    for (std::thread &worker : workers)
+        worker.join();
+}
+
+
+/*Public helpers*/
+u_int32_t task_pool::size() const
+{
+    return queues.size();
+}
+
+void task_pool::fork(task &t)
+{
+    u_int32_t idx = queue_index();
+    pending++;
+    {
+        std::lock_guard<std::mutex> guard(queues[idx]->lock);
+        queues[idx]->tasks.push_back(&t);
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(idle_lock);
+    }
+    idle.notify_one();
+}
+
+void task_pool::join(task &t)
+{
+    u_int32_t idx = queue_index();
+    while (!t.done.load(std::memory_order_acquire))
+    {
+        if (!run_one(idx))
+            std::this_thread::yield();
+    }
+}
+
+
+/*Private helpers*/
+u_int32_t task_pool::queue_index() const
+{
+    return owner == this ? self : 0;
+}
+
+task_pool::task* task_pool::pop(u_int32_t idx)
+{
+    std::lock_guard<std::mutex> guard(queues[idx]->lock);
+    if (queues[idx]->tasks.empty())
+        return nullptr;
+
+    task *t = queues[idx]->tasks.back();
+    queues[idx]->tasks.pop_back();
+    return t;
+}
+
+task_pool::task* task_pool::steal(u_int32_t idx)
+{
+    for (u_int32_t k = 1; k < queues.size(); k++)
+    {
+        worker_queue &victim = *queues[(idx + k) % queues.size()];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (!victim.tasks.empty())
+        {
+            task *t = victim.tasks.front();
+            victim.tasks.pop_front();
+            return t;
+        }
+    }
+
+    return nullptr;
+}
+
+bool task_pool::run_one(u_int32_t idx)
+{
+    task *t = pop(idx);
+    if (!t)
+        t = steal(idx);
+    if (!t)
+        return false;
+
+    pending--;
+    t->fn();
+    t->done.store(true, std::memory_order_release);
+    return true;
+}
+
+void task_pool::worker_loop(u_int32_t idx)
+{
+    owner = this;
+    self = idx;
+
+    while (!stop)
+    {
+        if (run_one(idx))
+            continue;
+
+        std::unique_lock<std::mutex> guard(idle_lock);
+        idle.wait(guard, [this] { return stop || pending > 0; });
+    }
+}
@@ -0,0 +1,62 @@
+#ifndef __TASK_POOL_H__
+#define __TASK_POOL_H__
+
+
+#include "vector"
+#include "deque"
+#include "memory"
+#include "functional"
+#include "atomic"
+#include "mutex"
+#include "condition_variable"
+#include "thread"
+
+/*
+ * Work-stealing pool for fork/join recursion. Every thread owns a deque: it pushes and pops its own
+ * tasks at the back and steals from the front of the others. Threads that are not part of the pool
+ * share queue 0. A joining thread never blocks, it keeps running pending tasks until its own finishes.
+ */
+class task_pool
+{
+public:
+    struct task
+    {
+        std::function<void()> fn;
+        std::atomic<bool> done{false};
+    };
+
+    explicit task_pool(u_int32_t threads);
+    task_pool(const task_pool &) = delete;
+    task_pool& operator=(const task_pool &) = delete;
+    ~task_pool();
+
+    u_int32_t size() const;
+    void fork(task &t);
+    void join(task &t);
+
+private:
+    struct worker_queue
+    {
+        std::mutex lock;
+        std::deque<task*> tasks;
+    };
+
+    std::vector<std::unique_ptr<worker_queue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<u_int32_t> pending;
+    std::atomic<bool> stop;
+    std::mutex idle_lock;
+    std::condition_variable idle;
+
+    static thread_local const task_pool *owner;
+    static thread_local u_int32_t self;
+
+    u_int32_t queue_index() const;
+    task* pop(u_int32_t idx);
+    task* steal(u_int32_t idx);
+    bool run_one(u_int32_t idx);
+    void worker_loop(u_int32_t idx);
+};
+
+
+#endif
@@ -0,0 +1,241 @@
+#include "bigint.h"
+#include "bigint_divisor.h"
+#include "chrono"
+#include "random"
+#include "memory"
+#include "sstream"
+
+/*
+ * Threshold tuning: built with -DBIGINT_TUNE, which makes the crossovers of bigint_thresholds.h writable, so
+ * each one can be timed on both sides in one binary. Thresholds are tuned in dependency order. For every size
+ * in a geometric sweep the operation is timed with the threshold just above the size (the lower tier runs) and
+ * at the size (the higher tier runs once at the top, the lower one below it), and the crossover is the first
+ * size from which the higher tier wins three sizes in a row. The result is written as a new
+ * bigint_thresholds.h; the library picks it up on the next build. NEWTON is written through as built: its
+ * crossover lies near 300000 limbs, where a single sweep step takes minutes.
+ *
+ * usage: tune [--out FILE] [--reps N] [--verbose]
+ */
+
+
+static std::mt19937_64 gen(20240601);
+static u_int32_t reps = 5;
+static bool verbose = false;
+
+
+class bigint_tune
+{
+public:
+    struct tunable
+    {
+        const char *name;
+        u_int32_t &value;
+    };
+
+    static std::vector<tunable> tunables()
+    {
+        return {
+            {"KARATSUBA", bigint::KARATSUBA_THRESHOLD}, {"TOOM3", bigint::TOOM3_THRESHOLD}, {"TOOM4", bigint::TOOM4_THRESHOLD},
+            {"NTT", bigint::NTT_THRESHOLD}, {"BZ", bigint::BZ_THRESHOLD}, {"BARRETT", bigint_divisor::BARRETT_THRESHOLD},
+            {"HGCD", bigint::HGCD_THRESHOLD}, {"CONVERSION", bigint::CONVERSION_THRESHOLD}, {"NEWTON", bigint::NEWTON_THRESHOLD},
+        };
+    }
+
+    static bigint random(u_int32_t limbs)
+    {
+        // Uniform limbs below the radix with a non-zero top limb
+        std::uniform_int_distribution<u_int64_t> limb(0, bigint::BASE - 1), lead(1, bigint::BASE - 1);
+        bigint ret;
+        ret.bignum.resize(limbs);
+        for (u_int32_t &l : ret.bignum)
+            l = limb(gen);
+        ret.bignum[limbs - 1] = lead(gen);
+        return ret;
+    }
+
+    static bool binary_limbs()
+    {
+        return bigint::BASE == 1ull << 32;
+    }
+};
+
+
+double measure(const std::function<void()> &fn)
+{
+    // Best of reps batches, each grown to at least 200us so the clock stays out of small sizes
+    auto run = [&](u_int64_t batch)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (u_int64_t k = 0; k < batch; k++)
+            fn();
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    u_int64_t batch = 1;
+    while (run(batch) < 2e5)
+        batch *= 2;
+
+    double best = run(batch);
+    for (u_int32_t rep = 1; rep < reps; rep++)
+        best = std::min(best, run(batch));
+    return best / batch;
+}
+
+u_int32_t crossover(const char *name, u_int32_t &threshold, u_int32_t lo, u_int32_t hi, const std::function<void(u_int32_t)> &prepare,
+                    const std::function<void()> &fn, const std::function<u_int32_t(u_int32_t)> &higher = [](u_int32_t n) { return n; })
+{
+    // Smallest size in [lo, hi] from which the higher tier wins three sweep steps in a row, or hi when it never does.
+    // higher(n) is the threshold that runs the higher tier at size n, n + 1 always runs the lower one
+    u_int32_t first = hi, wins = 0;
+    for (u_int32_t n = lo; n <= hi; n = std::max(n + 1, n + n / 8))
+    {
+        prepare(n);
+        threshold = n + 1;
+        double low = measure(fn);
+        threshold = higher(n);
+        double high = measure(fn);
+
+        if (verbose)
+            std::cerr << name << " " << n << ": " << low << " ns below, " << high << " ns above\n";
+
+        if (high < low)
+        {
+            if (!wins++)
+                first = n;
+            if (wins == 3)
+                break;
+        }
+        else
+        {
+            wins = 0;
+            first = hi;
+        }
+    }
+
+    threshold = first;
+    std::cerr << name << " " << first << "\n";
+    return first;
+}
+
+void tune_multiply()
+{
+    // Each tier is timed with every higher one out of the way, so the product at the top of the sweep only
+    // differs in the tier under test
+    bigint a, b, r;
+    auto prepare = [&](u_int32_t n)
+    {
+        a = bigint_tune::random(n);
+        b = bigint_tune::random(n);
+    };
+    auto mul = [&] { r = a * b; };
+    std::vector<bigint_tune::tunable> t = bigint_tune::tunables();
+    u_int32_t &karatsuba = t[0].value, &toom3 = t[1].value, &toom4 = t[2].value, &ntt = t[3].value;
+
+    toom3 = toom4 = ntt = UINT32_MAX / 2;
+    crossover("KARATSUBA", karatsuba, 8, 400, prepare, mul);
+    crossover("TOOM3", toom3, karatsuba, 3000, prepare, mul);
+    crossover("TOOM4", toom4, toom3, 10000, prepare, mul);
+    crossover("NTT", ntt, toom3, 100000, prepare, mul);
+}
+
+void tune_divide()
+{
+    // A 2n by n limb division: one Burnikel-Ziegler level splits the divisor in half, so it runs at the threshold
+    // (n + 1) / 2. bigint_divisor picks Barrett once per divisor, which is prepared outside the timing
+    bigint a, b, q, r;
+    std::unique_ptr<bigint_divisor> divisor;
+    u_int32_t built = 0;
+    std::vector<bigint_tune::tunable> t = bigint_tune::tunables();
+    u_int32_t &bz = t[4].value, &barrett = t[5].value;
+    auto prepare = [&](u_int32_t n)
+    {
+        a = bigint_tune::random(2 * n);
+        b = bigint_tune::random(n);
+        divisor.reset();
+    };
+
+    crossover("BZ", bz, 10, 1000, prepare, [&] { q = a / b; }, [](u_int32_t n) { return (n + 1) / 2; });
+    crossover("BARRETT", barrett, 10, 1000, prepare, [&]
+    {
+        if (!divisor || built != barrett)
+        {
+            divisor = std::make_unique<bigint_divisor>(b);
+            built = barrett;
+        }
+        divisor->divmod(a, q, r);
+    });
+}
+
+void tune_gcd()
+{
+    bigint a, b, g;
+    auto prepare = [&](u_int32_t n)
+    {
+        a = bigint_tune::random(n);
+        b = bigint_tune::random(n);
+    };
+    crossover("HGCD", bigint_tune::tunables()[6].value, 50, 5000, prepare, [&] { g = bigint::gcd(a, b); });
+}
+
+void tune_conversion()
+{
+    // Base 10^9 limbs convert in linear time, only the base 2^32 build has a divide-and-conquer tier
+    if (!bigint_tune::binary_limbs())
+        return;
+
+    bigint a, r;
+    std::string text;
+    auto prepare = [&](u_int32_t n)
+    {
+        a = bigint_tune::random(n);
+        text = a.to_string();
+    };
+    crossover("CONVERSION", bigint_tune::tunables()[7].value, 8, 1000, prepare, [&]
+    {
+        text = a.to_string();
+        r = bigint(text);
+    });
+}
+
+int main(int argc, char *argv[])
+{
+    std::string out_path;
+    for (int idx = 1; idx < argc; idx++)
+    {
+        std::string arg = argv[idx];
+        if (arg == "--out" && idx + 1 < argc)
+            out_path = argv[++idx];
+        else if (arg == "--reps" && idx + 1 < argc)
+            reps = std::max(1, atoi(argv[++idx]));
+        else if (arg == "--verbose")
+            verbose = true;
+        else
+        {
+            std::cerr << "usage: " << argv[0] << " [--out FILE] [--reps N] [--verbose]\n";
+            return 2;
+        }
+    }
+
+    tune_multiply();
+    tune_divide();
+    tune_gcd();
+    tune_conversion();
+
+    std::ostringstream header;
+    header << "#ifndef __BIGINT_THRESHOLDS_H__\n#define __BIGINT_THRESHOLDS_H__\n\n\n"
+           << "/*\n * Algorithm crossovers in limbs. make tune measures them on the host and rewrites this file,\n"
+           << " * these were measured for base " << (bigint_tune::binary_limbs() ? "2^32" : "10^9") << " limbs.\n */\n";
+    for (const bigint_tune::tunable &t : bigint_tune::tunables())
+        header << "#define BIGINT_" << t.name << "_THRESHOLD " << t.value << "\n";
+    header << "\n\n#endif\n";
+
+    if (out_path.empty())
+    {
+        std::cout << header.str();
+        return 0;
+    }
+
+    std::ofstream out(out_path);
+    out << header.str();
+    return out ? 0 : 1;
+}